@@ -1,9 +1,12 @@
 #include "actor_group.h"
+#include "binary_frame.h"
 #include "configuration.h"
 #include "create_actor.h"
 #include "create_network.h"
+#include "inference_service.h"
 #include "random.h"
 #include <algorithm>
+#include <cstdlib>
 #include <iostream>
 #include <memory>
 #include <string>
@@ -26,15 +29,33 @@ void ThreadSharedData::outputGame(const std::shared_ptr<BaseActor>& actor)
     int game_length = actor->getEnvironment().getActionHistory().size();
     std::pair<int, int> data_range = calculateTrainingDataRange(actor);
 
-    std::ostringstream oss;
     bool is_terminal = (config::zero_actor_intermediate_sequence_length == 0 || actor->isEnvTerminal());
-    oss << "SelfPlay "
-        << (is_terminal ? "true" : "false") << " "                                                                         // is terminal
-        << (data_range.second - data_range.first + 1) << " "                                                               // data length
-        << game_length << " "                                                                                              // game length
-        << actor->getEnvironment().getEvalScore(!actor->isEnvTerminal()) << " "                                            // return
-        << actor->getRecord({{"DLEN", std::to_string(data_range.first) + "-" + std::to_string(data_range.second)}}) << " " // game record
-        << "#";                                                                                                            // end mark for a valid game
+    // the data is tagged with the oldest model used for its moves, which is older than the current one after a switch
+    const std::string nn_file_name = actor->getNNFileName(data_range.first);
+    std::string record = actor->getRecord({{"DLEN", std::to_string(data_range.first) + "-" + std::to_string(data_range.second)},
+                                           {"EV", nn_file_name.substr(nn_file_name.find_last_of('/') + 1)}});
+    std::string message;
+    if (config::zero_actor_binary_self_play_data) {
+        BinaryFrameHeader header;
+        header.type_ = BinaryFrameHeader::Type::kSelfPlay;
+        header.flags_ = (is_terminal ? BinaryFrameHeader::kFlagTerminal : 0);
+        header.data_length_ = data_range.second - data_range.first + 1;
+        header.game_length_ = game_length;
+        header.return_ = actor->getEnvironment().getEvalScore(!actor->isEnvTerminal());
+        size_t model_iteration_pos = nn_file_name.find("weight_iter_");
+        header.model_iteration_ = (model_iteration_pos == std::string::npos ? 0 : std::atoi(nn_file_name.c_str() + model_iteration_pos + std::string("weight_iter_").size()));
+        message = header.toFrame(record);
+    } else {
+        std::ostringstream oss;
+        oss << "SelfPlay "
+            << (is_terminal ? "true" : "false") << " "                              // is terminal
+            << (data_range.second - data_range.first + 1) << " "                    // data length
+            << game_length << " "                                                   // game length
+            << actor->getEnvironment().getEvalScore(!actor->isEnvTerminal()) << " " // return
+            << record << " "                                                        // game record
+            << "#" << std::endl;                                                    // end mark for a valid game
+        message = oss.str();
+    }
 
     if (!is_terminal) {
         // delete action info history if not complete record to save memory
@@ -46,7 +67,8 @@ void ThreadSharedData::outputGame(const std::shared_ptr<BaseActor>& actor)
     }
 
     std::lock_guard lock(mutex_);
-    std::cout << oss.str() << std::endl;
+    std::cout.write(message.data(), message.size());
+    std::cout.flush();
 }
 
 std::pair<int, int> ThreadSharedData::calculateTrainingDataRange(const std::shared_ptr<BaseActor>& actor)
@@ -92,6 +114,11 @@ bool SlaveThread::doCPUJob()
         if (actor->isSearchDone()) { handleSearchDone(actor_id); }
     }
     actor->beforeNNEvaluation();
+    if (actor->getNNEvaluationBatchIndex() < 0 && actor->isSearchDone()) {
+        // the search is finished by cached evaluations without waiting for the network
+        // at most one search per job, the next search starts in the next cpu round since the batch index is -1
+        handleSearchDone(actor_id);
+    }
     return true;
 }
 
@@ -121,7 +148,11 @@ void SlaveThread::handleSearchDone(int actor_id)
     if (!actor->isResign()) { actor->act(actor->getSearchAction()); }
     bool is_endgame = (actor->isResign() || actor->isEnvTerminal());
     bool display_game = (actor_id == 0 && (config::actor_num_simulation >= 50 || (config::actor_num_simulation < 50 && is_endgame)));
-    if (display_game) { std::cerr << actor->getEnvironment().toString() << actor->getSearchInfo() << std::endl; }
+    if (display_game) {
+        std::cerr << actor->getEnvironment().toString() << actor->getSearchInfo();
+        if (getSharedData()->nn_evaluation_cache_) { std::cerr << getSharedData()->nn_evaluation_cache_->toString() << std::endl; }
+        std::cerr << std::endl;
+    }
     if (is_endgame) {
         getSharedData()->outputGame(actor);
         actor->reset();
@@ -133,11 +164,17 @@ void SlaveThread::handleSearchDone(int actor_id)
     }
 }
 
+ActorGroup::~ActorGroup()
+{
+    if (model_loader_thread_.joinable()) { model_loader_thread_.join(); }
+}
+
 void ActorGroup::run()
 {
     initialize();
     while (true) {
         handleCommand();
+        switchLoadedModel();
 
         if (!running_) { continue; }
         getSharedData()->actor_index_ = 0;
@@ -167,12 +204,22 @@ void ActorGroup::initialize()
 
 void ActorGroup::createNeuralNetworks()
 {
-    int num_networks = std::min(static_cast<int>(torch::cuda::device_count()), config::zero_num_parallel_games);
-    assert(num_networks > 0);
+    // a single remote network when sharing the inference service with other processes
+    if (!config::nn_inference_service_path.empty()) {
+        getSharedData()->networks_.resize(1);
+        getSharedData()->network_outputs_.resize(1);
+        getSharedData()->networks_[0] = std::make_shared<RemoteAlphaZeroNetwork>(config::nn_inference_service_path);
+        getSharedData()->networks_[0]->loadModel(config::nn_file_name, -1);
+        return;
+    }
+
+    // use a single cpu network when no gpu is available
+    int num_gpus = static_cast<int>(torch::cuda::device_count());
+    int num_networks = std::max(1, std::min(num_gpus, config::zero_num_parallel_games));
     getSharedData()->networks_.resize(num_networks);
     getSharedData()->network_outputs_.resize(num_networks);
-    for (int gpu_id = 0; gpu_id < num_networks; ++gpu_id) {
-        getSharedData()->networks_[gpu_id] = createNetwork(config::nn_file_name, gpu_id);
+    for (int id = 0; id < num_networks; ++id) {
+        getSharedData()->networks_[id] = createNetwork(config::nn_file_name, (num_gpus > 0 ? id : -1));
     }
 }
 
@@ -181,8 +228,14 @@ void ActorGroup::createActors()
     assert(getSharedData()->networks_.size() > 0);
     std::shared_ptr<Network>& network = getSharedData()->networks_[0];
     uint64_t tree_node_size = static_cast<uint64_t>(config::actor_num_simulation + 1) * network->getActionSize();
+    if (config::actor_nn_evaluation_cache_size > 0 && network->getNetworkTypeName() == "alphazero") {
+        // each entry holds the policy, policy logits, and value, plus about 128 bytes for the map and the shared pointer
+        uint64_t entry_size = (2 * network->getActionSize() + 1) * sizeof(float) + 128;
+        getSharedData()->nn_evaluation_cache_ = std::make_shared<NNEvaluationCache>(static_cast<uint64_t>(config::actor_nn_evaluation_cache_size) * 1024 * 1024 / entry_size);
+    }
     for (int i = 0; i < config::zero_num_parallel_games; ++i) {
         getSharedData()->actors_.emplace_back(createActor(tree_node_size, getSharedData()->networks_[i % getSharedData()->networks_.size()]));
+        if (getSharedData()->nn_evaluation_cache_) { getSharedData()->actors_.back()->setNNEvaluationCache(getSharedData()->nn_evaluation_cache_); }
     }
 }
 
@@ -218,6 +271,75 @@ void ActorGroup::handleCommand()
     }
 }
 
+void ActorGroup::loadModelInBackground(const std::string& nn_file_name)
+{
+    // searches keep running on the current model while the new one is loaded into the module cache of each device
+    // the networks switch to it in switchLoadedModel, which then only copies the fully loaded module
+    // called with the shared mutex held; a single loader thread always loads the newest requested model
+    requested_nn_file_name_ = nn_file_name;
+    if (is_model_loader_running_) { return; }
+    if (model_loader_thread_.joinable()) { model_loader_thread_.join(); } // the previous loader has released the mutex and is exiting
+    is_model_loader_running_ = true;
+    model_loader_thread_ = boost::thread(&ActorGroup::runModelLoader, this);
+}
+
+void ActorGroup::runModelLoader()
+{
+    std::vector<int> gpu_ids;
+    for (auto& network : getSharedData()->networks_) { gpu_ids.push_back(network->getGPUID()); }
+    while (true) {
+        std::string nn_file_name;
+        {
+            std::lock_guard lock(getSharedData()->mutex_);
+            if (requested_nn_file_name_.empty() || requested_nn_file_name_ == loaded_nn_file_name_) {
+                is_model_loader_running_ = false;
+                return;
+            }
+            nn_file_name = requested_nn_file_name_;
+        }
+
+        // with the inference service, the service loads the model while serving the current one
+        if (config::nn_inference_service_path.empty()) {
+            for (int gpu_id : gpu_ids) { Network::loadModule(nn_file_name, gpu_id); }
+        } else {
+            RemoteAlphaZeroNetwork::preloadModel(config::nn_inference_service_path, nn_file_name);
+        }
+        std::lock_guard lock(getSharedData()->mutex_);
+        loaded_nn_file_name_ = nn_file_name;
+    }
+}
+
+void ActorGroup::switchLoadedModel()
+{
+    // switch only at a batch boundary, i.e., after the gpu job has consumed all batches and before the cpu job starts
+    if (!getSharedData()->do_cpu_job_) { return; }
+
+    std::lock_guard lock(getSharedData()->mutex_);
+    if (requested_nn_file_name_.empty() || requested_nn_file_name_ != loaded_nn_file_name_) { return; }
+
+    std::cerr << "[model] switch to " << requested_nn_file_name_ << std::endl;
+    switchModel(requested_nn_file_name_);
+}
+
+void ActorGroup::switchModel(const std::string& nn_file_name)
+{
+    // called with the shared mutex held, at a batch boundary
+    config::nn_file_name = nn_file_name;
+    requested_nn_file_name_.clear();
+    loaded_nn_file_name_.clear();
+    for (auto& network : getSharedData()->networks_) { network->loadModel(config::nn_file_name, network->getGPUID()); }
+    if (getSharedData()->nn_evaluation_cache_) { getSharedData()->nn_evaluation_cache_->clear(); }
+
+    // alphazero searches continue on the new model, since the tree only keeps policies and values
+    // muzero trees keep hidden states of the previous model, which the new model cannot continue from,
+    // so the searches restart on the new model and the pending outputs of the previous model are dropped
+    const std::string network_type_name = getSharedData()->networks_[0]->getNetworkTypeName();
+    if (network_type_name == "muzero" || network_type_name == "muzero_atari") {
+        for (auto& actor : getSharedData()->actors_) { actor->resetSearch(); }
+        for (auto& network_output : getSharedData()->network_outputs_) { network_output.clear(); }
+    }
+}
+
 void ActorGroup::handleCommand(const std::string& command_prefix, const std::string& command)
 {
     if (command_prefix == "reset_actors") {
@@ -228,8 +350,11 @@ void ActorGroup::handleCommand(const std::string& command_prefix, const std::str
         std::cerr << "[command] " << command << std::endl;
         std::vector<std::string> args = utils::stringToVector(command);
         assert(args.size() == 2);
-        config::nn_file_name = args[1];
-        for (auto& network : getSharedData()->networks_) { network->loadModel(config::nn_file_name, network->getGPUID()); }
+        if (running_) {
+            loadModelInBackground(args[1]);
+        } else {
+            switchModel(args[1]);
+        }
     } else if (command_prefix == "update_config") {
         std::cerr << "[command] " << command << std::endl;
         assert(command.find(" ") != std::string::npos);
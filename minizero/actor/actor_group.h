@@ -3,6 +3,7 @@
 #include "base_actor.h"
 #include "network.h"
 #include "paralleler.h"
+#include <boost/thread.hpp>
 #include <deque>
 #include <memory>
 #include <mutex>
@@ -25,6 +26,7 @@ public:
     std::vector<std::shared_ptr<BaseActor>> actors_;
     std::vector<std::shared_ptr<network::Network>> networks_;
     std::vector<std::vector<std::shared_ptr<network::NetworkOutput>>> network_outputs_;
+    std::shared_ptr<NNEvaluationCache> nn_evaluation_cache_;
 };
 
 class SlaveThread : public utils::BaseSlaveThread {
@@ -45,7 +47,8 @@ protected:
 
 class ActorGroup : public utils::BaseParalleler {
 public:
-    ActorGroup() {}
+    ActorGroup() : is_model_loader_running_(false) {}
+    ~ActorGroup();
 
     void run();
     void initialize() override;
@@ -57,12 +60,20 @@ protected:
     virtual void handleIO();
     virtual void handleCommand();
     virtual void handleCommand(const std::string& command_prefix, const std::string& command);
+    virtual void loadModelInBackground(const std::string& nn_file_name);
+    virtual void runModelLoader();
+    virtual void switchLoadedModel();
+    virtual void switchModel(const std::string& nn_file_name);
 
     void createSharedData() override { shared_data_ = std::make_shared<ThreadSharedData>(); }
     std::shared_ptr<utils::BaseSlaveThread> newSlaveThread(int id) override { return std::make_shared<SlaveThread>(id, shared_data_); }
     inline std::shared_ptr<ThreadSharedData> getSharedData() { return std::static_pointer_cast<ThreadSharedData>(shared_data_); }
 
     bool running_;
+    bool is_model_loader_running_;
+    std::string requested_nn_file_name_; // the newest model to switch to, earlier requests not loaded yet are skipped
+    std::string loaded_nn_file_name_;    // the latest model loaded by the loader thread
+    boost::thread model_loader_thread_;
     std::deque<std::string> commands_;
     std::unordered_set<std::string> ignored_commands_;
 };
@@ -0,0 +1,182 @@
+#include "analysis_actor_group.h"
+#include "configuration.h"
+#include "time_system.h"
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <torch/cuda.h>
+
+namespace minizero::actor {
+
+using namespace utils;
+
+namespace {
+
+// quote a csv field, since file names may contain commas or quotes
+std::string toCSVField(const std::string& field)
+{
+    std::string quoted = "\"";
+    for (char c : field) { quoted += (c == '"' ? std::string(2, c) : std::string(1, c)); }
+    return quoted + "\"";
+}
+
+} // namespace
+
+bool AnalysisSharedData::loadNextPosition(int actor_id)
+{
+    std::shared_ptr<BaseActor>& actor = actors_[actor_id];
+    while (true) {
+        int position_id = -1;
+        {
+            std::lock_guard lock(mutex_);
+            if (next_position_id_ < static_cast<int>(positions_.size())) { position_id = next_position_id_++; }
+        }
+        actor_position_ids_[actor_id] = position_id;
+        if (position_id == -1) { return false; }
+
+        // replay the record to the position, positions that cannot be searched are skipped
+        const std::pair<std::string, int>& position = positions_[position_id];
+        EnvironmentLoader env_loader;
+        actor->reset();
+        bool is_valid = env_loader.loadFromFile(position.first);
+        int move_number = (position.second < 0 ? env_loader.getActionPairs().size() : position.second);
+        is_valid &= (move_number <= static_cast<int>(env_loader.getActionPairs().size()));
+        for (int i = 0; is_valid && i < move_number; ++i) { is_valid &= actor->act(env_loader.getActionPairs()[i].first); }
+        if (is_valid && !actor->isEnvTerminal()) {
+            actor->resetSearch();
+            return true;
+        }
+
+        std::lock_guard lock(mutex_);
+        std::cerr << "[AnalysisActorGroup] skip position " << position_id << ": " << position.first << " " << move_number
+                  << (is_valid ? " (terminal)" : " (invalid)") << std::endl;
+        ++num_skipped_positions_;
+    }
+}
+
+void AnalysisSharedData::outputResult(int actor_id)
+{
+    // position id, sgf file name, move number, selected action, root value, and the search distribution "id:count ..."
+    std::shared_ptr<BaseActor>& actor = actors_[actor_id];
+    const int position_id = actor_position_ids_[actor_id];
+    const SearchStatistics search_statistics = actor->getSearchStatistics();
+    std::ostringstream oss;
+    oss << position_id << ","
+        << toCSVField(positions_[position_id].first) << ","
+        << actor->getEnvironment().getActionHistory().size() << ","
+        << actor->getSearchAction().getActionID() << ","
+        << search_statistics.value_ << ",";
+    for (size_t i = 0; i < search_statistics.distribution_.size(); ++i) {
+        oss << (i == 0 ? "" : " ") << search_statistics.distribution_[i].first << ":" << search_statistics.distribution_[i].second;
+    }
+    oss << std::endl;
+
+    std::lock_guard lock(mutex_);
+    result_file_ << oss.str();
+    if (++num_analyzed_positions_ % 100 == 0) { std::cerr << "[AnalysisActorGroup] analyzed " << num_analyzed_positions_ << "/" << positions_.size() << " positions" << std::endl; }
+}
+
+bool AnalysisSlaveThread::doCPUJob()
+{
+    size_t actor_id = getSharedData()->getAvailableActorIndex();
+    if (actor_id >= getSharedData()->actors_.size()) { return false; }
+    if (getSharedData()->actor_position_ids_[actor_id] == -1) { return true; } // no position left for this actor
+
+    std::shared_ptr<BaseActor>& actor = getSharedData()->actors_[actor_id];
+    int network_id = actor_id % getSharedData()->networks_.size();
+    int network_output_id = actor->getNNEvaluationBatchIndex();
+    if (network_output_id >= 0) {
+        assert(network_output_id < static_cast<int>(getSharedData()->network_outputs_[network_id].size()));
+        actor->afterNNEvaluation(getSharedData()->network_outputs_[network_id][network_output_id]);
+        if (actor->isSearchDone()) { handleSearchDone(actor_id); }
+    }
+    if (getSharedData()->actor_position_ids_[actor_id] == -1) { return true; }
+    actor->beforeNNEvaluation();
+    if (actor->getNNEvaluationBatchIndex() < 0 && actor->isSearchDone()) {
+        // the search is finished by cached evaluations without waiting for the network
+        // at most one search per job, the next position starts in the next cpu round since the batch index is -1
+        handleSearchDone(actor_id);
+    }
+    return true;
+}
+
+void AnalysisSlaveThread::handleSearchDone(int actor_id)
+{
+    assert(getSharedData()->actors_[actor_id]->isSearchDone());
+    getSharedData()->outputResult(actor_id);
+    getSharedData()->loadNextPosition(actor_id);
+}
+
+void AnalysisActorGroup::run(const std::string& position_file_name, const std::string& result_file_name)
+{
+    initialize();
+    if (!loadPositions(position_file_name)) {
+        std::cerr << "[AnalysisActorGroup] failed to load positions from " << position_file_name << std::endl;
+        return;
+    }
+    getSharedData()->result_file_.open(result_file_name);
+    if (!getSharedData()->result_file_) {
+        std::cerr << "[AnalysisActorGroup] failed to open " << result_file_name << std::endl;
+        return;
+    }
+    getSharedData()->result_file_ << "position_id,sgf_file_name,move_number,action_id,value,search_distribution" << std::endl;
+
+    boost::posix_time::ptime start_ptime = TimeSystem::getLocalTime();
+    std::shared_ptr<AnalysisSharedData> shared_data = getSharedData();
+    shared_data->next_position_id_ = 0;
+    shared_data->num_analyzed_positions_ = 0;
+    shared_data->num_skipped_positions_ = 0;
+    shared_data->actor_position_ids_.assign(shared_data->actors_.size(), -1);
+    for (size_t actor_id = 0; actor_id < shared_data->actors_.size(); ++actor_id) { shared_data->loadNextPosition(actor_id); }
+    while (std::any_of(shared_data->actor_position_ids_.begin(), shared_data->actor_position_ids_.end(), [](int position_id) { return position_id != -1; })) {
+        shared_data->actor_index_ = 0;
+        for (auto& t : slave_threads_) { t->start(); }
+        for (auto& t : slave_threads_) { t->finish(); }
+        shared_data->do_cpu_job_ = !shared_data->do_cpu_job_;
+    }
+    shared_data->result_file_.close();
+
+    double seconds = (TimeSystem::getLocalTime() - start_ptime).total_microseconds() / 1e6;
+    std::cerr << "[AnalysisActorGroup] analyzed " << shared_data->num_analyzed_positions_ << " positions in " << seconds << "s"
+              << " (" << shared_data->num_analyzed_positions_ / std::max(seconds, 1e-6) << " positions/s, "
+              << shared_data->num_skipped_positions_ << " skipped), results are written to " << result_file_name << std::endl;
+}
+
+void AnalysisActorGroup::initialize()
+{
+    // every position is searched with actor_num_simulation, i.e., no fast search of playout cap randomization,
+    // without root noise, and the action is the most visited one, so that the results are reproducible analyses
+    config::actor_playout_cap_full_search_ratio = 1.0f;
+    config::actor_use_dirichlet_noise = false;
+    config::actor_use_gumbel_noise = false;
+    config::actor_select_action_by_count = true;
+    config::actor_select_action_by_softmax_count = false;
+
+    int num_threads = std::max(static_cast<int>(torch::cuda::device_count()), config::zero_num_threads);
+    createSlaveThreads(num_threads);
+    createNeuralNetworks();
+    createActors();
+    running_ = true;
+    getSharedData()->do_cpu_job_ = true;
+}
+
+bool AnalysisActorGroup::loadPositions(const std::string& position_file_name)
+{
+    std::ifstream fin(position_file_name);
+    if (!fin) { return false; }
+
+    std::string line;
+    while (std::getline(fin, line)) {
+        if (!line.empty() && line.back() == '\r') { line.pop_back(); }
+        std::istringstream iss(line);
+        std::string sgf_file_name;
+        int move_number = -1;
+        if (!(iss >> sgf_file_name) || sgf_file_name[0] == '#') { continue; }
+        if (!(iss >> move_number)) { move_number = -1; }
+        getSharedData()->positions_.emplace_back(sgf_file_name, move_number);
+    }
+    return true;
+}
+
+} // namespace minizero::actor
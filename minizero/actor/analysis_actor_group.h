@@ -0,0 +1,57 @@
+#pragma once
+
+#include "actor_group.h"
+#include <fstream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace minizero::actor {
+
+class AnalysisSharedData : public ThreadSharedData {
+public:
+    bool loadNextPosition(int actor_id);
+    void outputResult(int actor_id);
+
+    int next_position_id_;
+    int num_analyzed_positions_;
+    int num_skipped_positions_;
+    std::vector<std::pair<std::string, int>> positions_;
+    std::vector<int> actor_position_ids_;
+    std::ofstream result_file_;
+};
+
+class AnalysisSlaveThread : public SlaveThread {
+public:
+    AnalysisSlaveThread(int id, std::shared_ptr<utils::BaseSharedData> shared_data)
+        : SlaveThread(id, shared_data) {}
+
+protected:
+    bool doCPUJob() override;
+    void handleSearchDone(int actor_id) override;
+    inline std::shared_ptr<AnalysisSharedData> getSharedData() { return std::static_pointer_cast<AnalysisSharedData>(shared_data_); }
+};
+
+/*
+ * AnalysisActorGroup searches a list of positions offline, running zero_num_parallel_games roots concurrently
+ * with the same batched cpu/gpu jobs as self-play, and writes the search result of each position to a csv file
+ * each line of the position file is "sgf_file_name move_number", where the position is the one after move_number moves
+ * (all moves if omitted); only the first record of each sgf file is used
+ */
+class AnalysisActorGroup : public ActorGroup {
+public:
+    AnalysisActorGroup() {}
+
+    void run(const std::string& position_file_name, const std::string& result_file_name);
+    void initialize() override;
+
+protected:
+    bool loadPositions(const std::string& position_file_name);
+
+    void createSharedData() override { shared_data_ = std::make_shared<AnalysisSharedData>(); }
+    std::shared_ptr<utils::BaseSlaveThread> newSlaveThread(int id) override { return std::make_shared<AnalysisSlaveThread>(id, shared_data_); }
+    inline std::shared_ptr<AnalysisSharedData> getSharedData() { return std::static_pointer_cast<AnalysisSharedData>(shared_data_); }
+};
+
+} // namespace minizero::actor
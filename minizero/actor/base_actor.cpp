@@ -9,12 +9,14 @@ void BaseActor::reset()
 {
     env_.reset();
     action_info_history_.clear();
+    nn_file_name_history_.clear();
     resetSearch();
 }
 
 void BaseActor::resetSearch()
 {
     nn_evaluation_batch_id_ = -1;
+    search_nn_file_name_ = config::nn_file_name;
     if (!search_) { search_ = createSearch(); }
     search_->reset();
 }
@@ -25,6 +27,7 @@ bool BaseActor::act(const Action& action)
     if (can_act) {
         action_info_history_.resize(env_.getActionHistory().size());
         action_info_history_.back() = getActionInfo();
+        if (nn_file_name_history_.empty() || nn_file_name_history_.back().second != search_nn_file_name_) { nn_file_name_history_.push_back({static_cast<int>(action_info_history_.size()) - 1, search_nn_file_name_}); }
     }
     return can_act;
 }
@@ -35,6 +38,7 @@ bool BaseActor::act(const std::vector<std::string>& action_string_args)
     if (can_act) {
         action_info_history_.resize(env_.getActionHistory().size());
         action_info_history_.back() = getActionInfo();
+        if (nn_file_name_history_.empty() || nn_file_name_history_.back().second != search_nn_file_name_) { nn_file_name_history_.push_back({static_cast<int>(action_info_history_.size()) - 1, search_nn_file_name_}); }
     }
     return can_act;
 }
@@ -43,7 +47,8 @@ std::string BaseActor::getRecord(const std::unordered_map<std::string, std::stri
 {
     EnvironmentLoader env_loader;
     env_loader.loadFromEnvironment(env_, action_info_history_);
-    env_loader.addTag("EV", config::nn_file_name.substr(config::nn_file_name.find_last_of('/') + 1));
+    std::string nn_file_name = getNNFileName(0);
+    env_loader.addTag("EV", nn_file_name.substr(nn_file_name.find_last_of('/') + 1));
 
     // if the game is not ended, then treat the game as a resign game, where the next player is the lose side
     if (!isEnvTerminal()) {
@@ -56,9 +61,24 @@ std::string BaseActor::getRecord(const std::unordered_map<std::string, std::stri
     return env_loader.toString();
 }
 
+std::string BaseActor::getNNFileName(int move_id) const
+{
+    // a move is played by the model its search started on, which is the oldest model used for the move after a switch
+    for (size_t i = 0; i < nn_file_name_history_.size(); ++i) {
+        if (i + 1 == nn_file_name_history_.size() || nn_file_name_history_[i + 1].first > move_id) { return nn_file_name_history_[i].second; }
+    }
+    return search_nn_file_name_; // no move played yet
+}
+
 std::vector<std::pair<std::string, std::string>> BaseActor::getActionInfo() const
 {
     std::vector<std::pair<std::string, std::string>> action_info;
+    if (config::actor_record_binary_search_statistics) {
+        std::string search_statistics = getSearchStatistics().encode();
+        assert(utils::SearchStatistics().decode(search_statistics));
+        action_info.push_back({"S", search_statistics});
+        return action_info;
+    }
     action_info.push_back({"P", getMCTSPolicy()});
     action_info.push_back({"V", getMCTSValue()});
     action_info.push_back({"R", getEnvReward()});
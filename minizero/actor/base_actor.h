@@ -2,7 +2,9 @@
 
 #include "environment.h"
 #include "network.h"
+#include "nn_evaluation_cache.h"
 #include "search.h"
+#include "search_statistics.h"
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -29,6 +31,8 @@ public:
     inline Environment& getEnvironment() { return env_; }
     inline const Environment& getEnvironment() const { return env_; }
     inline const int getNNEvaluationBatchIndex() const { return nn_evaluation_batch_id_; }
+    inline const std::string& getSearchNNFileName() const { return search_nn_file_name_; }
+    std::string getNNFileName(int move_id) const;
     inline std::vector<std::vector<std::pair<std::string, std::string>>>& getActionInfoHistory() { return action_info_history_; }
     inline const std::vector<std::vector<std::pair<std::string, std::string>>>& getActionInfoHistory() const { return action_info_history_; }
 
@@ -40,7 +44,9 @@ public:
     virtual bool isResign() const = 0;
     virtual std::string getSearchInfo() const = 0;
     virtual void setNetwork(const std::shared_ptr<network::Network>& network) = 0;
+    virtual void setNNEvaluationCache(const std::shared_ptr<NNEvaluationCache>& nn_evaluation_cache) {}
     virtual std::shared_ptr<Search> createSearch() = 0;
+    virtual utils::SearchStatistics getSearchStatistics() const = 0;
 
 protected:
     virtual std::vector<std::pair<std::string, std::string>> getActionInfo() const;
@@ -49,6 +55,8 @@ protected:
     virtual std::string getEnvReward() const = 0;
 
     int nn_evaluation_batch_id_;
+    std::string search_nn_file_name_;                              // the model when the current search started
+    std::vector<std::pair<int, std::string>> nn_file_name_history_; // the first move played by each model and the model
     Environment env_;
     std::shared_ptr<Search> search_;
     std::vector<std::vector<std::pair<std::string, std::string>>> action_info_history_;
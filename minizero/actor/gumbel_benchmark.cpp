@@ -0,0 +1,175 @@
+#include "gumbel_benchmark.h"
+#include "configuration.h"
+#include "gumbel_zero.h"
+#include "random.h"
+#include "time_system.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+
+namespace minizero::actor {
+
+using namespace minizero::utils;
+
+namespace {
+
+// the candidate handling of GumbelZero before the scores were cached and the candidates partially sorted
+// a stable sort is used, so that equal scores keep the order of candidates on every standard library
+class ReferenceGumbelZero {
+public:
+    MCTSNode* decideActionNode(const std::shared_ptr<MCTS>& mcts)
+    {
+        sortCandidatesByScore(mcts);
+        return candidates_[0];
+    }
+
+    void selection(const std::shared_ptr<MCTS>& mcts, std::vector<MCTSNode*>& node_path)
+    {
+        if (mcts->getNumSimulation() == 0) {
+            mcts->select(node_path);
+        } else {
+            std::stable_sort(candidates_.begin(), candidates_.end(), [](const MCTSNode* lhs, const MCTSNode* rhs) {
+                return (lhs->getCount() < rhs->getCount() || (lhs->getCount() == rhs->getCount() && lhs->getPolicyLogit() > rhs->getPolicyLogit()));
+            });
+            node_path.clear();
+            node_path.push_back(mcts->getRootNode());
+            mcts->selectFromNode(candidates_[0], node_path);
+        }
+    }
+
+    void sequentialHalving(const std::shared_ptr<MCTS>& mcts)
+    {
+        if (mcts->getNumSimulation() == 1) {
+            candidates_.clear();
+            for (int i = 0; i < mcts->getRootNode()->getNumChildren(); ++i) { candidates_.push_back(mcts->getRootNode()->getChild(i)); }
+            std::stable_sort(candidates_.begin(), candidates_.end(), [](const MCTSNode* lhs, const MCTSNode* rhs) { return lhs->getPolicyLogit() > rhs->getPolicyLogit(); });
+            if (static_cast<int>(candidates_.size()) > config::actor_gumbel_sample_size) { candidates_.resize(config::actor_gumbel_sample_size); }
+            sample_size_ = config::actor_gumbel_sample_size;
+            simulation_budget_ = std::max(1.0, std::floor(mcts->getNumSimulationLimit() / (std::log2(config::actor_gumbel_sample_size) * sample_size_)));
+        } else {
+            for (auto node : candidates_) {
+                if (node->getCount() < simulation_budget_) { return; }
+            }
+            int next_budget = std::floor(mcts->getNumSimulationLimit() / (std::log2(config::actor_gumbel_sample_size) * sample_size_ / 2));
+            if (next_budget > 0 && sample_size_ > 2) {
+                sample_size_ /= 2;
+                sortCandidatesByScore(mcts);
+                if (static_cast<int>(candidates_.size()) > sample_size_) { candidates_.resize(sample_size_); }
+                simulation_budget_ = candidates_[0]->getCount() + next_budget;
+            }
+        }
+    }
+
+private:
+    void sortCandidatesByScore(const std::shared_ptr<MCTS>& mcts)
+    {
+        float max_child_count = 0;
+        for (int i = 0; i < mcts->getRootNode()->getNumChildren(); ++i) { max_child_count = fmax(max_child_count, mcts->getRootNode()->getChild(i)->getCount()); }
+        auto& tree_value_bound = mcts->getTreeValueBound();
+        std::stable_sort(candidates_.begin(), candidates_.end(), [&](const MCTSNode* lhs, const MCTSNode* rhs) {
+            float min_value = -std::numeric_limits<float>::max();
+            float lhs_value = lhs->getNormalizedMean(tree_value_bound);
+            float lhs_score = lhs->getPolicyLogit() + (config::actor_gumbel_sigma_visit_c + max_child_count) * config::actor_gumbel_sigma_scale_c * lhs_value;
+            lhs_score = (lhs->getCount() > 0 ? lhs_score : min_value);
+            float rhs_value = rhs->getNormalizedMean(tree_value_bound);
+            float rhs_score = rhs->getPolicyLogit() + (config::actor_gumbel_sigma_visit_c + max_child_count) * config::actor_gumbel_sigma_scale_c * rhs_value;
+            rhs_score = (rhs->getCount() > 0 ? rhs_score : min_value);
+            return lhs_score > rhs_score;
+        });
+    }
+
+    int sample_size_;
+    int simulation_budget_;
+    std::vector<MCTSNode*> candidates_;
+};
+
+} // namespace
+
+bool GumbelBenchmark::run()
+{
+    config::actor_use_gumbel = true;
+    config::actor_select_action_by_count = true;
+    Random::seed(config::program_seed);
+    uint64_t tree_node_size = static_cast<uint64_t>(config::actor_num_simulation + 1) * env_.getPolicySize();
+    mcts_ = std::make_shared<MCTS>(tree_node_size);
+    node_path_.reserve(config::actor_num_simulation + 1);
+
+    // each search starts from the same random state for both implementations, the game continues with the decision of GumbelZero
+    GumbelZero gumbel_zero;
+    ReferenceGumbelZero reference_gumbel_zero;
+    int num_searches = 0, num_mismatched_searches = 0;
+    double seconds = 0.0f, reference_seconds = 0.0f;
+    std::vector<int> counts;
+    for (int game = 0; game < num_games_; ++game) {
+        env_.reset();
+        for (int move = 0; move < num_moves_ && !env_.isTerminal(); ++move) {
+            const std::mt19937 generator = Random::generator_;
+            boost::posix_time::ptime start_ptime = TimeSystem::getLocalTime();
+            const MCTSNode* reference_node = runSearch(reference_gumbel_zero);
+            reference_seconds += (TimeSystem::getLocalTime() - start_ptime).total_microseconds() / 1e6;
+            const int reference_action_id = reference_node->getAction().getActionID();
+            counts.clear();
+            for (int i = 0; i < mcts_->getRootNode()->getNumChildren(); ++i) { counts.push_back(mcts_->getRootNode()->getChild(i)->getCount()); }
+
+            Random::generator_ = generator;
+            start_ptime = TimeSystem::getLocalTime();
+            const MCTSNode* node = runSearch(gumbel_zero);
+            seconds += (TimeSystem::getLocalTime() - start_ptime).total_microseconds() / 1e6;
+            bool is_matched = (node->getAction().getActionID() == reference_action_id && mcts_->getRootNode()->getNumChildren() == static_cast<int>(counts.size()));
+            for (int i = 0; is_matched && i < mcts_->getRootNode()->getNumChildren(); ++i) { is_matched = (mcts_->getRootNode()->getChild(i)->getCount() == counts[i]); }
+
+            ++num_searches;
+            if (!is_matched) { ++num_mismatched_searches; }
+            env_.act(node->getAction());
+        }
+    }
+
+    bool is_passed = (num_searches > 0 && num_mismatched_searches == 0);
+    std::cout << "searches " << num_searches
+              << " simulations " << config::actor_num_simulation
+              << " mismatched searches " << num_mismatched_searches << std::endl;
+    std::cout << "time: gumbel zero " << std::fixed << std::setprecision(3) << seconds << "s"
+              << ", reference " << reference_seconds << "s" << std::endl;
+    std::cout << (is_passed ? "PASSED" : "FAILED") << std::endl;
+    return is_passed;
+}
+
+template <class Gumbel>
+MCTSNode* GumbelBenchmark::runSearch(Gumbel& gumbel)
+{
+    mcts_->reset();
+    while (!mcts_->reachMaximumSimulation()) {
+        gumbel.selection(mcts_, node_path_);
+        env_transition_ = env_;
+        for (size_t i = 1; i < node_path_.size(); ++i) { env_transition_.act(node_path_[i]->getAction()); }
+        bool is_terminal = env_transition_.isTerminal();
+        float value = (is_terminal ? env_transition_.getEvalScore() : Random::randReal() * 2 - 1);
+        if (!is_terminal) {
+            action_candidates_.clear();
+            for (int action_id = 0; action_id < env_transition_.getPolicySize(); ++action_id) {
+                Action action(action_id, env_transition_.getTurn());
+                if (env_transition_.isLegalAction(action)) { action_candidates_.push_back(MCTS::ActionCandidate(action, 0.0f, Random::randReal() * 4)); }
+            }
+            for (auto& candidate : action_candidates_) { candidate.policy_ = 1.0f / action_candidates_.size(); }
+            mcts_->expand(node_path_.back(), action_candidates_);
+
+            // the root logits are perturbed by Gumbel noise as in self-play
+            MCTSNode* node = node_path_.back();
+            if (node == mcts_->getRootNode()) {
+                std::vector<float> noise = Random::randGumbel(node->getNumChildren());
+                for (int i = 0; i < node->getNumChildren(); ++i) {
+                    node->getChild(i)->setPolicyNoise(noise[i]);
+                    node->getChild(i)->setPolicyLogit(node->getChild(i)->getPolicyLogit() + noise[i]);
+                }
+            }
+        }
+        mcts_->backup(node_path_, value, env_transition_.getReward());
+        gumbel.sequentialHalving(mcts_);
+    }
+    return gumbel.decideActionNode(mcts_);
+}
+
+} // namespace minizero::actor
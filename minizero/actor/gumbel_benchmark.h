@@ -0,0 +1,39 @@
+#pragma once
+
+#include "environment.h"
+#include "mcts.h"
+#include <memory>
+#include <vector>
+
+namespace minizero::actor {
+
+/*
+ * GumbelBenchmark runs fixed-seed Gumbel searches without a network, with random logits, Gumbel noise, and values,
+ * and runs every search twice from the same random state: once with GumbelZero, and once with a reference implementation
+ * that fully sorts the candidates and computes the scores in each comparison
+ * the decisions and the root visit counts are expected to be identical, and the time of both implementations is reported
+ */
+class GumbelBenchmark {
+public:
+    GumbelBenchmark(int num_games, int num_moves)
+        : num_games_(num_games),
+          num_moves_(num_moves)
+    {
+    }
+
+    bool run();
+
+private:
+    template <class Gumbel>
+    MCTSNode* runSearch(Gumbel& gumbel);
+
+    int num_games_;
+    int num_moves_;
+    Environment env_;
+    Environment env_transition_;
+    std::shared_ptr<MCTS> mcts_;
+    std::vector<MCTSNode*> node_path_;
+    std::vector<MCTS::ActionCandidate> action_candidates_;
+};
+
+} // namespace minizero::actor
@@ -2,11 +2,11 @@
 #include <algorithm>
 #include <limits>
 #include <memory>
-#include <unordered_map>
+#include <sstream>
 
 namespace minizero::actor {
 
-std::string GumbelZero::getMCTSPolicy(const std::shared_ptr<MCTS>& mcts) const
+std::vector<std::pair<int, float>> GumbelZero::getMCTSPolicyDistribution(const std::shared_ptr<MCTS>& mcts) const
 {
     // calculate value for non-visisted nodes
     float pi_sum = 0.0f, q_sum = 0.0f;
@@ -29,10 +29,10 @@ std::string GumbelZero::getMCTSPolicy(const std::shared_ptr<MCTS>& mcts) const
         }
     }
     value_pi = (mcts->getRootNode()->getChild(0)->getAction().getPlayer() == env::charToPlayer(config::actor_mcts_value_flipping_player) ? -value_pi : value_pi);
-    float non_visited_node_value = 1.0 / (1 + config::actor_num_simulation) * (value_pi + (config::actor_num_simulation / pi_sum) * q_sum);
+    float non_visited_node_value = 1.0 / (1 + mcts->getNumSimulationLimit()) * (value_pi + (mcts->getNumSimulationLimit() / pi_sum) * q_sum);
 
     // calculate completed Q-values
-    std::unordered_map<int, float> new_logits;
+    std::vector<std::pair<int, float>> new_logits;
     float max_logit = -std::numeric_limits<float>::max();
     float max_child_count = 0;
     for (int i = 0; i < mcts->getRootNode()->getNumChildren(); ++i) { max_child_count = fmax(max_child_count, mcts->getRootNode()->getChild(i)->getCount()); }
@@ -41,18 +41,27 @@ std::string GumbelZero::getMCTSPolicy(const std::shared_ptr<MCTS>& mcts) const
         float value = (child->getCount() == 0 ? non_visited_node_value : child->getNormalizedMean(mcts->getTreeValueBound()));
         float logit_without_noise = child->getPolicyLogit() - child->getPolicyNoise();
         float score = logit_without_noise + (config::actor_gumbel_sigma_visit_c + max_child_count) * config::actor_gumbel_sigma_scale_c * value;
-        new_logits.insert({child->getAction().getActionID(), score});
+        new_logits.emplace_back(child->getAction().getActionID(), score);
         max_logit = fmax(max_logit, score);
     }
 
     // return normalized completed Q-values
-    std::ostringstream oss;
+    std::vector<std::pair<int, float>> distribution;
     for (auto& logit : new_logits) {
         logit.second = logit.second - max_logit;
         if (logit.second < -38)
             continue;
+        distribution.emplace_back(logit.first, exp(logit.second));
+    }
+    return distribution;
+}
+
+std::string GumbelZero::getMCTSPolicy(const std::shared_ptr<MCTS>& mcts) const
+{
+    std::ostringstream oss;
+    for (const auto& p : getMCTSPolicyDistribution(mcts)) {
         oss << (oss.str().empty() ? "" : ",")
-            << logit.first << ":" << exp(logit.second);
+            << p.first << ":" << p.second;
     }
     return oss.str();
 }
@@ -61,7 +70,7 @@ MCTSNode* GumbelZero::decideActionNode(const std::shared_ptr<MCTS>& mcts)
 {
     if (config::actor_select_action_by_count) {
         assert(candidates_.size() > 0);
-        sortCandidatesByScore(mcts);
+        sortCandidatesByScore(mcts, 1);
         return candidates_[0];
     } else if (config::actor_select_action_by_softmax_count) {
         return mcts->selectChildBySoftmaxCount(mcts->getRootNode(), config::actor_select_action_softmax_temperature);
@@ -71,20 +80,20 @@ MCTSNode* GumbelZero::decideActionNode(const std::shared_ptr<MCTS>& mcts)
     return nullptr;
 }
 
-std::vector<MCTSNode*> GumbelZero::selection(const std::shared_ptr<MCTS>& mcts)
+void GumbelZero::selection(const std::shared_ptr<MCTS>& mcts, std::vector<MCTSNode*>& node_path)
 {
-    std::vector<MCTSNode*> node_path;
     if (mcts->getNumSimulation() == 0) {
-        node_path = mcts->select();
+        mcts->select(node_path);
     } else {
+        // only the least visited candidate is needed, the first one is kept among equals as a stable sort would do
         assert(candidates_.size() > 0);
-        sort(candidates_.begin(), candidates_.end(), [](const MCTSNode* lhs, const MCTSNode* rhs) {
+        auto candidate = std::min_element(candidates_.begin(), candidates_.end(), [](const MCTSNode* lhs, const MCTSNode* rhs) {
             return (lhs->getCount() < rhs->getCount() || (lhs->getCount() == rhs->getCount() && lhs->getPolicyLogit() > rhs->getPolicyLogit()));
         });
-        node_path = mcts->selectFromNode(candidates_[0]);
-        node_path.insert(node_path.begin(), mcts->getRootNode());
+        node_path.clear();
+        node_path.push_back(mcts->getRootNode());
+        mcts->selectFromNode(*candidate, node_path);
     }
-    return node_path;
 }
 
 void GumbelZero::sequentialHalving(const std::shared_ptr<MCTS>& mcts)
@@ -92,11 +101,15 @@ void GumbelZero::sequentialHalving(const std::shared_ptr<MCTS>& mcts)
     if (mcts->getNumSimulation() == 1) {
         // collect candidates
         candidates_.clear();
-        for (int i = 0; i < mcts->getRootNode()->getNumChildren(); ++i) { candidates_.push_back(mcts->getRootNode()->getChild(i)); }
-        sort(candidates_.begin(), candidates_.end(), [](const MCTSNode* lhs, const MCTSNode* rhs) { return lhs->getPolicyLogit() > rhs->getPolicyLogit(); });
+        candidate_scores_.clear();
+        for (int i = 0; i < mcts->getRootNode()->getNumChildren(); ++i) {
+            candidates_.push_back(mcts->getRootNode()->getChild(i));
+            candidate_scores_.push_back({candidates_.back()->getPolicyLogit(), i});
+        }
+        sortCandidates(config::actor_gumbel_sample_size);
         if (static_cast<int>(candidates_.size()) > config::actor_gumbel_sample_size) { candidates_.resize(config::actor_gumbel_sample_size); }
         sample_size_ = config::actor_gumbel_sample_size;
-        simulation_budget_ = std::max(1.0, std::floor(config::actor_num_simulation / (std::log2(config::actor_gumbel_sample_size) * sample_size_)));
+        simulation_budget_ = std::max(1.0, std::floor(mcts->getNumSimulationLimit() / (std::log2(config::actor_gumbel_sample_size) * sample_size_)));
     } else {
         bool all_candidates_reach_budget = true;
         for (auto node : candidates_) {
@@ -106,11 +119,11 @@ void GumbelZero::sequentialHalving(const std::shared_ptr<MCTS>& mcts)
         }
 
         if (all_candidates_reach_budget) {
-            int next_budget = std::floor(config::actor_num_simulation / (std::log2(config::actor_gumbel_sample_size) * sample_size_ / 2));
+            int next_budget = std::floor(mcts->getNumSimulationLimit() / (std::log2(config::actor_gumbel_sample_size) * sample_size_ / 2));
             if (next_budget > 0 && sample_size_ > 2) {
                 sample_size_ /= 2;
                 assert(sample_size_ > 0);
-                sortCandidatesByScore(mcts);
+                sortCandidatesByScore(mcts, sample_size_);
                 if (static_cast<int>(candidates_.size()) > sample_size_) { candidates_.resize(sample_size_); }
                 simulation_budget_ = candidates_[0]->getCount() + next_budget;
             }
@@ -118,22 +131,39 @@ void GumbelZero::sequentialHalving(const std::shared_ptr<MCTS>& mcts)
     }
 }
 
-void GumbelZero::sortCandidatesByScore(const std::shared_ptr<MCTS>& mcts)
+void GumbelZero::sortCandidatesByScore(const std::shared_ptr<MCTS>& mcts, int num_top_candidates)
 {
     assert(!candidates_.empty());
     float max_child_count = 0;
     for (int i = 0; i < mcts->getRootNode()->getNumChildren(); ++i) { max_child_count = fmax(max_child_count, mcts->getRootNode()->getChild(i)->getCount()); }
     auto& tree_value_bound = mcts->getTreeValueBound();
-    sort(candidates_.begin(), candidates_.end(), [&](const MCTSNode* lhs, const MCTSNode* rhs) {
+
+    // the score of each candidate is computed once, instead of in every comparison
+    candidate_scores_.clear();
+    for (size_t i = 0; i < candidates_.size(); ++i) {
+        const MCTSNode* candidate = candidates_[i];
         float min_value = -std::numeric_limits<float>::max();
-        float lhs_value = lhs->getNormalizedMean(tree_value_bound);
-        float lhs_score = lhs->getPolicyLogit() + (config::actor_gumbel_sigma_visit_c + max_child_count) * config::actor_gumbel_sigma_scale_c * lhs_value;
-        lhs_score = (lhs->getCount() > 0 ? lhs_score : min_value);
-        float rhs_value = rhs->getNormalizedMean(tree_value_bound);
-        float rhs_score = rhs->getPolicyLogit() + (config::actor_gumbel_sigma_visit_c + max_child_count) * config::actor_gumbel_sigma_scale_c * rhs_value;
-        rhs_score = (rhs->getCount() > 0 ? rhs_score : min_value);
-        return lhs_score > rhs_score;
-    });
+        float value = candidate->getNormalizedMean(tree_value_bound);
+        float score = candidate->getPolicyLogit() + (config::actor_gumbel_sigma_visit_c + max_child_count) * config::actor_gumbel_sigma_scale_c * value;
+        candidate_scores_.push_back({(candidate->getCount() > 0 ? score : min_value), i});
+    }
+    sortCandidates(num_top_candidates);
+}
+
+void GumbelZero::sortCandidates(int num_top_candidates)
+{
+    // move the top candidates by candidate_scores_ to the front in order, the order of the others is unspecified
+    // equal scores keep the current order of candidates, so the result does not depend on the sorting algorithm
+    assert(candidate_scores_.size() == candidates_.size());
+    auto compare = [](const std::pair<float, int>& lhs, const std::pair<float, int>& rhs) {
+        return (lhs.first > rhs.first || (lhs.first == rhs.first && lhs.second < rhs.second));
+    };
+    int num_sorted = std::min(num_top_candidates, static_cast<int>(candidate_scores_.size()));
+    std::partial_sort(candidate_scores_.begin(), candidate_scores_.begin() + num_sorted, candidate_scores_.end(), compare);
+
+    sorted_candidates_.clear();
+    for (auto& candidate_score : candidate_scores_) { sorted_candidates_.push_back(candidates_[candidate_score.second]); }
+    candidates_.swap(sorted_candidates_);
 }
 
 } // namespace minizero::actor
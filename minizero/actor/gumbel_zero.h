@@ -3,22 +3,28 @@
 #include "mcts.h"
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace minizero::actor {
 
 class GumbelZero {
 public:
+    std::vector<std::pair<int, float>> getMCTSPolicyDistribution(const std::shared_ptr<MCTS>& mcts) const;
     std::string getMCTSPolicy(const std::shared_ptr<MCTS>& mcts) const;
     MCTSNode* decideActionNode(const std::shared_ptr<MCTS>& mcts);
-    std::vector<MCTSNode*> selection(const std::shared_ptr<MCTS>& mcts);
+    void selection(const std::shared_ptr<MCTS>& mcts, std::vector<MCTSNode*>& node_path);
     void sequentialHalving(const std::shared_ptr<MCTS>& mcts);
-    void sortCandidatesByScore(const std::shared_ptr<MCTS>& mcts);
+    void sortCandidatesByScore(const std::shared_ptr<MCTS>& mcts, int num_top_candidates);
 
 private:
+    void sortCandidates(int num_top_candidates);
+
     int sample_size_;
     int simulation_budget_;
     std::vector<MCTSNode*> candidates_;
+    std::vector<MCTSNode*> sorted_candidates_;
+    std::vector<std::pair<float, int>> candidate_scores_;
 };
 
 } // namespace minizero::actor
@@ -79,6 +79,9 @@ void MCTS::reset()
     Tree::reset();
     tree_hidden_state_data_.reset();
     tree_value_bound_.clear();
+    transposition_table_.clear();
+    num_simulation_limit_ = config::actor_num_simulation;
+    num_transposition_hits_ = 0;
 }
 
 bool MCTS::isResign(const MCTSNode* selected_node) const
@@ -103,6 +106,23 @@ MCTSNode* MCTS::selectChildByMaxCount(const MCTSNode* node) const
     return selected;
 }
 
+float MCTS::getMaxCountLead(const MCTSNode* node) const
+{
+    // the count difference between the most and the second most visited children
+    assert(node && !node->isLeaf());
+    float max_count = 0.0f, second_count = 0.0f;
+    for (int i = 0; i < node->getNumChildren(); ++i) {
+        float count = node->getChild(i)->getCount();
+        if (count > max_count) {
+            second_count = max_count;
+            max_count = count;
+        } else if (count > second_count) {
+            second_count = count;
+        }
+    }
+    return max_count - second_count;
+}
+
 MCTSNode* MCTS::selectChildBySoftmaxCount(const MCTSNode* node, float temperature /* = 1.0f */, float value_threshold /* = 0.1f */) const
 {
     assert(node && !node->isLeaf());
@@ -123,29 +143,45 @@ MCTSNode* MCTS::selectChildBySoftmaxCount(const MCTSNode* node, float temperatur
     return selected;
 }
 
-std::string MCTS::getSearchDistributionString() const
+std::vector<std::pair<int, float>> MCTS::getSearchDistribution() const
 {
     const MCTSNode* root = getRootNode();
-    std::ostringstream oss;
+    std::vector<std::pair<int, float>> distribution;
     for (int i = 0; i < root->getNumChildren(); ++i) {
         MCTSNode* child = root->getChild(i);
         if (child->getCount() == 0) { continue; }
+        distribution.emplace_back(child->getAction().getActionID(), child->getCount());
+    }
+    return distribution;
+}
+
+std::string MCTS::getSearchDistributionString() const
+{
+    std::ostringstream oss;
+    for (const auto& p : getSearchDistribution()) {
         oss << (oss.str().empty() ? "" : ",")
-            << child->getAction().getActionID() << ":" << child->getCount();
+            << p.first << ":" << p.second;
     }
     return oss.str();
 }
 
-std::vector<MCTSNode*> MCTS::selectFromNode(MCTSNode* start_node)
+void MCTS::select(std::vector<MCTSNode*>& node_path)
+{
+    // the path is filled into the caller's buffer, which keeps its capacity across simulations
+    node_path.clear();
+    selectFromNode(getRootNode(), node_path);
+}
+
+void MCTS::selectFromNode(MCTSNode* start_node, std::vector<MCTSNode*>& node_path)
 {
+    // append the path from start_node to a leaf
     assert(start_node);
     MCTSNode* node = start_node;
-    std::vector<MCTSNode*> node_path{node};
+    node_path.push_back(node);
     while (!node->isLeaf()) {
         node = selectChildByPUCTScore(node);
         node_path.push_back(node);
     }
-    return node_path;
 }
 
 void MCTS::expand(MCTSNode* leaf_node, const std::vector<ActionCandidate>& action_candidates)
@@ -9,7 +9,9 @@
 #include <cmath>
 #include <limits>
 #include <map>
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace minizero::actor {
@@ -64,13 +66,7 @@ protected:
     float reward_;
 };
 
-class HiddenStateData {
-public:
-    HiddenStateData(const std::vector<float>& hidden_state)
-        : hidden_state_(hidden_state) {}
-    std::vector<float> hidden_state_;
-};
-typedef TreeData<HiddenStateData> TreeHiddenStateData;
+typedef TreeSlabData TreeHiddenStateData;
 
 class MCTS : public Tree, public Search {
 public:
@@ -89,33 +85,44 @@ public:
     void reset() override;
     virtual bool isResign(const MCTSNode* selected_node) const;
     virtual MCTSNode* selectChildByMaxCount(const MCTSNode* node) const;
+    virtual float getMaxCountLead(const MCTSNode* node) const;
     virtual MCTSNode* selectChildBySoftmaxCount(const MCTSNode* node, float temperature = 1.0f, float value_threshold = 0.1f) const;
+    virtual std::vector<std::pair<int, float>> getSearchDistribution() const;
     virtual std::string getSearchDistributionString() const;
-    virtual std::vector<MCTSNode*> select() { return selectFromNode(getRootNode()); }
-    virtual std::vector<MCTSNode*> selectFromNode(MCTSNode* start_node);
+    virtual void select(std::vector<MCTSNode*>& node_path);
+    virtual void selectFromNode(MCTSNode* start_node, std::vector<MCTSNode*>& node_path);
     virtual void expand(MCTSNode* leaf_node, const std::vector<ActionCandidate>& action_candidates);
     virtual void backup(const std::vector<MCTSNode*>& node_path, const float value, const float reward = 0.0f);
 
     inline MCTSNode* allocateNodes(int size) { return static_cast<MCTSNode*>(Tree::allocateNodes(size)); }
     inline int getNumSimulation() const { return getRootNode()->getCount(); }
-    inline bool reachMaximumSimulation() const { return (getNumSimulation() == config::actor_num_simulation + 1); }
+    inline bool reachMaximumSimulation() const { return (getNumSimulation() == num_simulation_limit_ + 1); }
+    inline int getNumSimulationLimit() const { return num_simulation_limit_; }
+    inline void setNumSimulationLimit(int num_simulation_limit) { num_simulation_limit_ = num_simulation_limit; }
     inline MCTSNode* getRootNode() { return static_cast<MCTSNode*>(Tree::getRootNode()); }
     inline const MCTSNode* getRootNode() const { return static_cast<const MCTSNode*>(Tree::getRootNode()); }
     inline TreeHiddenStateData& getTreeHiddenStateData() { return tree_hidden_state_data_; }
     inline const TreeHiddenStateData& getTreeHiddenStateData() const { return tree_hidden_state_data_; }
     inline std::map<float, int>& getTreeValueBound() { return tree_value_bound_; }
     inline const std::map<float, int>& getTreeValueBound() const { return tree_value_bound_; }
+    inline std::unordered_map<uint64_t, MCTSNode*>& getTranspositionTable() { return transposition_table_; }
+    inline const std::unordered_map<uint64_t, MCTSNode*>& getTranspositionTable() const { return transposition_table_; }
+    inline int getNumTranspositionHits() const { return num_transposition_hits_; }
+    inline void addTranspositionHit() { ++num_transposition_hits_; }
 
 protected:
-    TreeNode* createTreeNodes(uint64_t tree_node_size) override { return new MCTSNode[tree_node_size]; }
-    TreeNode* getNodeIndex(int index) override { return getRootNode() + index; }
+    std::shared_ptr<TreeNode> createTreeNodes(uint64_t tree_node_size) override { return std::shared_ptr<TreeNode>(new MCTSNode[tree_node_size], std::default_delete<MCTSNode[]>()); }
+    TreeNode* getNodeIndex(TreeNode* nodes, uint64_t index) override { return static_cast<MCTSNode*>(nodes) + index; }
 
     virtual MCTSNode* selectChildByPUCTScore(const MCTSNode* node) const;
     virtual float calculateInitQValue(const MCTSNode* node) const;
     virtual void updateTreeValueBound(float old_value, float new_value);
 
+    int num_simulation_limit_;
+    int num_transposition_hits_;
     std::map<float, int> tree_value_bound_;
     TreeHiddenStateData tree_hidden_state_data_;
+    std::unordered_map<uint64_t, MCTSNode*> transposition_table_;
 };
 
 } // namespace minizero::actor
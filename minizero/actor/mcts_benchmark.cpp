@@ -0,0 +1,111 @@
+#include "mcts_benchmark.h"
+#include "configuration.h"
+#include "random.h"
+#include "time_system.h"
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+
+namespace {
+
+// every allocation through the global operator new is counted per thread, so that the benchmark can check its own allocations
+// replacing the global operator new affects the whole program, so it is only compiled with the cmake option COUNT_ALLOCATIONS
+thread_local uint64_t num_allocations = 0;
+
+} // namespace
+
+#ifdef COUNT_ALLOCATIONS
+void* operator new(std::size_t size)
+{
+    ++num_allocations;
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) { return ptr; }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+#endif
+
+namespace minizero::actor {
+
+using namespace minizero::utils;
+
+void MCTSBenchmark::run()
+{
+    env_.reset();
+    uint64_t tree_node_size = static_cast<uint64_t>(config::actor_num_simulation + 1) * env_.getPolicySize();
+    mcts_ = std::make_shared<MCTS>(tree_node_size);
+    node_path_.reserve(config::actor_num_simulation + 1);
+
+    // the first search is for warming up the buffers and not counted
+    // a search that grows the tree by new node blocks allocates on purpose, its mcts allocations are not counted either
+    uint64_t num_simulations = 0, num_mcts_allocations = 0, num_env_allocations = 0, num_tree_growths = 0;
+    boost::posix_time::ptime start_ptime;
+    for (int search = 0; search <= num_searches_; ++search) {
+        if (search == 1) { start_ptime = TimeSystem::getLocalTime(); }
+        mcts_->reset();
+        uint64_t num_reserved_nodes = mcts_->getNumReservedNodes();
+        num_mcts_allocations_ = num_env_allocations_ = 0;
+        while (!mcts_->reachMaximumSimulation()) { runSimulation(); }
+        if (search == 0) { continue; }
+        num_simulations += mcts_->getNumSimulation();
+        if (mcts_->getNumReservedNodes() == num_reserved_nodes) {
+            num_mcts_allocations += num_mcts_allocations_;
+        } else {
+            ++num_tree_growths;
+        }
+        num_env_allocations += num_env_allocations_;
+    }
+    double seconds = (TimeSystem::getLocalTime() - start_ptime).total_microseconds() / 1e6;
+
+    std::cout << "searches " << num_searches_
+              << " simulations " << num_simulations
+              << " time " << std::fixed << std::setprecision(3) << seconds << "s"
+              << " simulations/s " << std::setprecision(1) << num_simulations / seconds << std::endl;
+#ifdef COUNT_ALLOCATIONS
+    std::cout << "allocations per simulation: mcts " << std::setprecision(3) << num_mcts_allocations * 1.0 / num_simulations
+              << ", environment transition " << num_env_allocations * 1.0 / num_simulations << std::endl;
+#else
+    std::cout << "allocations are not counted, build with -DCOUNT_ALLOCATIONS=ON to count them" << std::endl;
+#endif
+    std::cout << "tree nodes: reserved " << mcts_->getNumReservedNodes()
+              << ", worst case " << mcts_->getMaxNumNodes()
+              << ", node size " << sizeof(MCTSNode) << " bytes"
+              << ", searches growing the tree " << num_tree_growths << std::endl;
+
+    // the value bound of value rescaling is a std::map, which allocates for new values
+    if (!config::actor_mcts_value_rescale && num_mcts_allocations > 0) {
+        std::cerr << "[MCTSBenchmark] selection, expansion, and backup should not allocate after warming up, but got " << num_mcts_allocations << " allocations" << std::endl;
+        exit(-1);
+    }
+}
+
+void MCTSBenchmark::runSimulation()
+{
+    uint64_t start_allocations = num_allocations;
+    mcts_->select(node_path_);
+    num_mcts_allocations_ += num_allocations - start_allocations;
+
+    start_allocations = num_allocations;
+    env_transition_ = env_;
+    for (size_t i = 1; i < node_path_.size(); ++i) { env_transition_.act(node_path_[i]->getAction()); }
+    bool is_terminal = env_transition_.isTerminal();
+    float value = (is_terminal ? env_transition_.getEvalScore() : Random::randReal() * 2 - 1);
+    action_candidates_.clear();
+    if (!is_terminal) {
+        for (int action_id = 0; action_id < env_transition_.getPolicySize(); ++action_id) {
+            Action action(action_id, env_transition_.getTurn());
+            if (env_transition_.isLegalAction(action)) { action_candidates_.push_back(MCTS::ActionCandidate(action, 0.0f, 0.0f)); }
+        }
+        for (auto& candidate : action_candidates_) { candidate.policy_ = 1.0f / action_candidates_.size(); }
+    }
+    num_env_allocations_ += num_allocations - start_allocations;
+
+    start_allocations = num_allocations;
+    if (!action_candidates_.empty()) { mcts_->expand(node_path_.back(), action_candidates_); }
+    mcts_->backup(node_path_, value, env_transition_.getReward());
+    num_mcts_allocations_ += num_allocations - start_allocations;
+}
+
+} // namespace minizero::actor
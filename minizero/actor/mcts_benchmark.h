@@ -0,0 +1,39 @@
+#pragma once
+
+#include "environment.h"
+#include "mcts.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace minizero::actor {
+
+/*
+ * MCTSBenchmark runs searches without a network, expanding leaves with a uniform policy and a random value,
+ * to measure the simulation throughput and the heap allocations of the tree operations
+ * after the first search, selection, expansion, and backup are expected to reuse their buffers and never allocate
+ * allocations are only counted in builds with the cmake option COUNT_ALLOCATIONS, which replaces the global operator new
+ */
+class MCTSBenchmark {
+public:
+    MCTSBenchmark(int num_searches)
+        : num_searches_(num_searches)
+    {
+    }
+
+    void run();
+
+private:
+    void runSimulation();
+
+    int num_searches_;
+    uint64_t num_mcts_allocations_;
+    uint64_t num_env_allocations_;
+    Environment env_;
+    Environment env_transition_;
+    std::shared_ptr<MCTS> mcts_;
+    std::vector<MCTSNode*> node_path_;
+    std::vector<MCTS::ActionCandidate> action_candidates_;
+};
+
+} // namespace minizero::actor
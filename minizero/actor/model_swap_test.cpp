@@ -0,0 +1,168 @@
+#include "model_swap_test.h"
+#include "configuration.h"
+#include "create_network.h"
+#include "muzero_network.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace minizero::actor {
+
+using namespace network;
+
+const float kProbeOutputTolerance = 1e-3;
+
+bool isSameOutput(const std::shared_ptr<AlphaZeroNetworkOutput>& output, const std::shared_ptr<AlphaZeroNetworkOutput>& reference)
+{
+    if (std::fabs(output->value_ - reference->value_) > kProbeOutputTolerance) { return false; }
+    for (size_t i = 0; i < reference->policy_logits_.size(); ++i) {
+        if (std::fabs(output->policy_logits_[i] - reference->policy_logits_[i]) > kProbeOutputTolerance) { return false; }
+    }
+    return true;
+}
+
+void ModelSwapTestSlaveThread::doGPUJob()
+{
+    if (id_ >= static_cast<int>(getSharedData()->networks_.size())) { return; }
+
+    std::shared_ptr<Network>& network = getSharedData()->networks_[id_];
+    bool is_matched = true;
+    if (network->getNetworkTypeName() == "alphazero") {
+        std::shared_ptr<AlphaZeroNetwork> az_network = std::static_pointer_cast<AlphaZeroNetwork>(network);
+        if (az_network->getBatchSize() == 0) { return; }
+
+        // the probe is appended after the leaves of the actors, so their batch indices are unchanged
+        int probe_index = az_network->pushBack(getSharedData()->probe_features_);
+        std::vector<std::shared_ptr<NetworkOutput>> network_outputs = az_network->forward();
+        std::shared_ptr<AlphaZeroNetworkOutput> probe_output = std::static_pointer_cast<AlphaZeroNetworkOutput>(network_outputs[probe_index]);
+        network_outputs.pop_back();
+        getSharedData()->network_outputs_[id_] = std::move(network_outputs);
+
+        // the batch must be forwarded through the fully loaded module of the current model
+        is_matched = isSameOutput(probe_output, getSharedData()->probe_outputs_.at(config::nn_file_name));
+    } else {
+        std::shared_ptr<MuZeroNetwork> muzero_network = std::static_pointer_cast<MuZeroNetwork>(network);
+        if (muzero_network->getInitialInputBatchSize() == 0 && muzero_network->getRecurrentInputBatchSize() == 0) { return; }
+
+        // every search waiting for this batch must have started on the current model,
+        // otherwise hidden states of the previous model are forwarded through the current one
+        for (size_t actor_id = id_; actor_id < getSharedData()->actors_.size(); actor_id += getSharedData()->networks_.size()) {
+            const std::shared_ptr<BaseActor>& actor = getSharedData()->actors_[actor_id];
+            if (actor->getNNEvaluationBatchIndex() >= 0 && actor->getSearchNNFileName() != config::nn_file_name) { is_matched = false; }
+        }
+        SlaveThread::doGPUJob();
+    }
+    is_matched &= (network->getNetworkFileName() == config::nn_file_name);
+
+    std::lock_guard lock(getSharedData()->mutex_);
+    ++getSharedData()->num_checked_batches_;
+    if (!is_matched) { ++getSharedData()->num_mismatched_batches_; }
+}
+
+void ModelSwapTestSlaveThread::handleSearchDone(int actor_id)
+{
+    std::shared_ptr<BaseActor>& actor = getSharedData()->actors_[actor_id];
+    if (!actor->isResign()) { actor->act(actor->getSearchAction()); }
+    if (!actor->isResign() && !actor->isEnvTerminal()) {
+        actor->resetSearch();
+        return;
+    }
+
+    {
+        std::lock_guard lock(getSharedData()->mutex_);
+        ++getSharedData()->num_games_[actor->getNNFileName(0)];
+    }
+    actor->reset();
+}
+
+bool ModelSwapTest::run(const std::string& nn_file_name, const std::string& other_nn_file_name)
+{
+    config::nn_file_name = nn_file_name;
+    config::nn_inference_service_path = "";
+    initialize();
+    std::shared_ptr<ModelSwapTestSharedData> shared_data = getSharedData();
+    const std::string network_type_name = shared_data->networks_[0]->getNetworkTypeName();
+    if (network_type_name == "alphazero") {
+        // reference outputs of the probe, evaluated by networks that are not involved in the switches
+        Environment env;
+        env.reset();
+        shared_data->probe_features_ = env.getFeatures();
+        for (const std::string& file_name : {nn_file_name, other_nn_file_name}) {
+            std::shared_ptr<AlphaZeroNetwork> reference_network = std::static_pointer_cast<AlphaZeroNetwork>(createNetwork(file_name, -1));
+            reference_network->pushBack(shared_data->probe_features_);
+            shared_data->probe_outputs_[file_name] = std::static_pointer_cast<AlphaZeroNetworkOutput>(reference_network->forward()[0]);
+        }
+        if (isSameOutput(shared_data->probe_outputs_[nn_file_name], shared_data->probe_outputs_[other_nn_file_name])) {
+            std::cerr << "[ModelSwapTest] the two models give the same output, use models with different weights" << std::endl;
+            return false;
+        }
+    } else if (network_type_name != "muzero" && network_type_name != "muzero_atari") {
+        std::cerr << "[ModelSwapTest] unsupported network type " << network_type_name << std::endl;
+        return false;
+    }
+
+    // requests alternate between the two models, some are sent right after the previous one so that they overlap with its loading
+    const int num_requests = 20;
+    int num_switches = 0;
+    std::string last_nn_file_name = nn_file_name;
+    for (int request = 0; request < num_requests; ++request) {
+        last_nn_file_name = (last_nn_file_name == nn_file_name ? other_nn_file_name : nn_file_name);
+        {
+            std::lock_guard lock(shared_data->mutex_);
+            commands_.push_back("load_model " + last_nn_file_name);
+        }
+        const int num_batches = (request % 3 == 2 ? 200 : 2);
+        for (int i = 0; i < num_batches; ++i) { num_switches += runBatch(); }
+    }
+
+    // keep searching until the last request is switched to
+    for (int i = 0; i < 100000 && config::nn_file_name != last_nn_file_name; ++i) { num_switches += runBatch(); }
+    bool is_switched = (config::nn_file_name == last_nn_file_name);
+    for (auto& network : shared_data->networks_) { is_switched &= (network->getNetworkFileName() == last_nn_file_name); }
+
+    bool is_passed = (is_switched && shared_data->num_checked_batches_ > 0 && shared_data->num_mismatched_batches_ == 0);
+    std::cout << "requests " << num_requests
+              << ", switches " << num_switches
+              << ", checked batches " << shared_data->num_checked_batches_
+              << ", mismatched batches " << shared_data->num_mismatched_batches_
+              << ", switched to the last request " << (is_switched ? "yes" : "no") << std::endl;
+    for (const auto& p : shared_data->num_games_) { std::cout << "games started on " << p.first << ": " << p.second << std::endl; }
+    std::cout << (is_passed ? "PASSED" : "FAILED") << std::endl;
+    return is_passed;
+}
+
+void ModelSwapTest::initialize()
+{
+    createSlaveThreads(std::max(1, config::zero_num_threads));
+    createNeuralNetworks();
+    createActors();
+    running_ = true;
+    getSharedData()->do_cpu_job_ = true;
+    getSharedData()->num_checked_batches_ = 0;
+    getSharedData()->num_mismatched_batches_ = 0;
+}
+
+void ModelSwapTest::createNeuralNetworks()
+{
+    getSharedData()->networks_.resize(1);
+    getSharedData()->network_outputs_.resize(1);
+    getSharedData()->networks_[0] = createNetwork(config::nn_file_name, -1);
+}
+
+bool ModelSwapTest::runBatch()
+{
+    // the same loop as ActorGroup::run, returns whether the model is switched before this job
+    const std::string nn_file_name = config::nn_file_name;
+    handleCommand();
+    switchLoadedModel();
+    getSharedData()->actor_index_ = 0;
+    for (auto& t : slave_threads_) { t->start(); }
+    for (auto& t : slave_threads_) { t->finish(); }
+    getSharedData()->do_cpu_job_ = !getSharedData()->do_cpu_job_;
+    return config::nn_file_name != nn_file_name;
+}
+
+} // namespace minizero::actor
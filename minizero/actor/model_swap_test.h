@@ -0,0 +1,56 @@
+#pragma once
+
+#include "actor_group.h"
+#include "alphazero_network.h"
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace minizero::actor {
+
+class ModelSwapTestSharedData : public ThreadSharedData {
+public:
+    int num_checked_batches_;
+    int num_mismatched_batches_;
+    std::vector<float> probe_features_;
+    std::map<std::string, std::shared_ptr<network::AlphaZeroNetworkOutput>> probe_outputs_; // model -> reference output of the probe
+    std::map<std::string, int> num_games_;                                                   // model the game started on -> number of games
+};
+
+class ModelSwapTestSlaveThread : public SlaveThread {
+public:
+    ModelSwapTestSlaveThread(int id, std::shared_ptr<utils::BaseSharedData> shared_data)
+        : SlaveThread(id, shared_data) {}
+
+protected:
+    void doGPUJob() override;
+    void handleSearchDone(int actor_id) override;
+    inline std::shared_ptr<ModelSwapTestSharedData> getSharedData() { return std::static_pointer_cast<ModelSwapTestSharedData>(shared_data_); }
+};
+
+/*
+ * ModelSwapTest runs self-play on cpu with an alphazero or muzero model, and keeps requesting switches between two models,
+ * including overlapping requests, while the searches are running
+ * for alphazero, a probe position is appended to every batch and its output is compared with that of a separately loaded reference network,
+ * so that a batch forwarded through a module other than the fully loaded current one is detected
+ * for muzero, every search waiting for a batch must have started on the current model, so that no hidden state of the previous model is forwarded
+ * the test passes if all batches match, and the group ends on the model of the last request
+ */
+class ModelSwapTest : public ActorGroup {
+public:
+    ModelSwapTest() {}
+
+    bool run(const std::string& nn_file_name, const std::string& other_nn_file_name);
+    void initialize() override;
+
+protected:
+    void createNeuralNetworks() override;
+    bool runBatch();
+
+    void createSharedData() override { shared_data_ = std::make_shared<ModelSwapTestSharedData>(); }
+    std::shared_ptr<utils::BaseSlaveThread> newSlaveThread(int id) override { return std::make_shared<ModelSwapTestSlaveThread>(id, shared_data_); }
+    inline std::shared_ptr<ModelSwapTestSharedData> getSharedData() { return std::static_pointer_cast<ModelSwapTestSharedData>(shared_data_); }
+};
+
+} // namespace minizero::actor
@@ -0,0 +1,84 @@
+#include "nn_evaluation_cache.h"
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
+namespace minizero::actor {
+
+NNEvaluationCache::NNEvaluationCache(size_t max_num_entries)
+    : max_num_entries_per_shard_(std::max<size_t>(1, max_num_entries / kNumShards)),
+      shards_(kNumShards),
+      version_(0),
+      num_lookups_(0),
+      num_hits_(0)
+{
+}
+
+NNEvaluationCache::Key NNEvaluationCache::getKey(const std::vector<float>& features) const
+{
+    return {hashFeatures(features), hashFeatures(features, kVerificationSeed), version_};
+}
+
+std::shared_ptr<network::NetworkOutput> NNEvaluationCache::lookup(const Key& key)
+{
+    Shard& shard = getShard(key.hash_key_);
+    std::lock_guard<std::mutex> lock(shard.mutex_);
+    ++num_lookups_;
+    auto it = shard.entries_.find(key.hash_key_);
+    if (it == shard.entries_.end() || it->second.first != key.verification_key_) { return nullptr; }
+    ++num_hits_;
+    return it->second.second;
+}
+
+void NNEvaluationCache::store(const Key& key, const std::shared_ptr<network::NetworkOutput>& network_output)
+{
+    // the version is checked with the shard locked, and clear() bumps it before clearing the shards
+    Shard& shard = getShard(key.hash_key_);
+    std::lock_guard<std::mutex> lock(shard.mutex_);
+    if (key.version_ != version_) { return; } // evaluated by the model before the last clear
+    if (!shard.entries_.emplace(key.hash_key_, std::make_pair(key.verification_key_, network_output)).second) { return; }
+    shard.insertion_order_.push_back(key.hash_key_);
+    if (shard.insertion_order_.size() > max_num_entries_per_shard_) {
+        shard.entries_.erase(shard.insertion_order_.front());
+        shard.insertion_order_.pop_front();
+    }
+}
+
+void NNEvaluationCache::clear()
+{
+    ++version_;
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex_);
+        shard.entries_.clear();
+        shard.insertion_order_.clear();
+    }
+}
+
+std::string NNEvaluationCache::toString() const
+{
+    std::ostringstream oss;
+    uint64_t num_lookups = num_lookups_, num_hits = num_hits_;
+    oss << "nn evaluation cache: lookups " << num_lookups
+        << ", hits " << num_hits
+        << ", hit rate " << (num_lookups == 0 ? 0.0f : num_hits * 1.0f / num_lookups);
+    return oss.str();
+}
+
+uint64_t NNEvaluationCache::hashFeatures(const std::vector<float>& features, uint64_t seed /*= 0*/)
+{
+    // hash the raw bits of the features 8 bytes at a time, with the finalizer of splitmix64
+    const char* data = reinterpret_cast<const char*>(features.data());
+    size_t size = features.size() * sizeof(float);
+    uint64_t hash_key = size ^ seed;
+    for (size_t offset = 0; offset < size; offset += sizeof(uint64_t)) {
+        uint64_t word = 0;
+        std::memcpy(&word, data + offset, std::min(sizeof(uint64_t), size - offset));
+        hash_key = (hash_key ^ word) * 0x9e3779b97f4a7c15ULL;
+        hash_key ^= hash_key >> 32;
+    }
+    hash_key = (hash_key ^ (hash_key >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    hash_key = (hash_key ^ (hash_key >> 27)) * 0x94d049bb133111ebULL;
+    return hash_key ^ (hash_key >> 31);
+}
+
+} // namespace minizero::actor
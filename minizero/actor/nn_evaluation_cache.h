@@ -0,0 +1,63 @@
+#pragma once
+
+#include "network.h"
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace minizero::actor {
+
+/*
+ * NNEvaluationCache keeps recent network outputs for actors sharing the same network
+ * entries are keyed by the hash of the input features, which already reflect the position, its history, and the rotation,
+ * and a second independent hash is kept to verify a hit, so that a collision of the first hash is never used as an evaluation
+ * the cache must be cleared when the model changes, which also bumps its version; a key carries the version at the time its
+ * features are sent to the network, so that outputs of batches started on the previous model are not stored afterwards
+ * it is split into shards to reduce lock contention between threads, and each shard evicts its oldest entries when full
+ */
+class NNEvaluationCache {
+public:
+    class Key {
+    public:
+        uint64_t hash_key_;
+        uint64_t verification_key_;
+        uint64_t version_;
+    };
+
+    NNEvaluationCache(size_t max_num_entries);
+
+    Key getKey(const std::vector<float>& features) const;
+    std::shared_ptr<network::NetworkOutput> lookup(const Key& key);
+    void store(const Key& key, const std::shared_ptr<network::NetworkOutput>& network_output);
+    void clear();
+    std::string toString() const;
+    inline uint64_t getVersion() const { return version_; }
+
+    static uint64_t hashFeatures(const std::vector<float>& features, uint64_t seed = 0);
+
+private:
+    class Shard {
+    public:
+        std::mutex mutex_;
+        std::unordered_map<uint64_t, std::pair<uint64_t, std::shared_ptr<network::NetworkOutput>>> entries_; // hash key -> verification key, output
+        std::deque<uint64_t> insertion_order_;
+    };
+
+    inline Shard& getShard(uint64_t hash_key) { return shards_[hash_key % kNumShards]; }
+
+    static const int kNumShards = 16;
+    static const uint64_t kVerificationSeed = 0x2545f4914f6cdd1dULL;
+    size_t max_num_entries_per_shard_;
+    std::vector<Shard> shards_;
+    std::atomic<uint64_t> version_;
+    std::atomic<uint64_t> num_lookups_;
+    std::atomic<uint64_t> num_hits_;
+};
+
+} // namespace minizero::actor
@@ -0,0 +1,101 @@
+#include "nn_evaluation_cache_test.h"
+#include "alphazero_network.h"
+#include "configuration.h"
+#include "create_actor.h"
+#include "create_network.h"
+#include "random.h"
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace minizero::actor {
+
+using namespace network;
+
+const size_t kTestCacheSize = 100000;
+
+bool NNEvaluationCacheTest::run()
+{
+    config::actor_mcts_think_batch_size = 1;
+    config::actor_mcts_think_time_limit = 0;
+    config::actor_use_random_rotation_features = false; // the positions searched again by later moves hit the cache
+    config::nn_inference_service_path = "";
+    if (createNetwork(config::nn_file_name, -1)->getNetworkTypeName() != "alphazero") {
+        std::cerr << "[NNEvaluationCacheTest] only alphazero models are supported" << std::endl;
+        return false;
+    }
+
+    std::shared_ptr<NNEvaluationCache> nn_evaluation_cache = std::make_shared<NNEvaluationCache>(kTestCacheSize);
+    std::vector<std::string> records = runGame(nullptr);
+    std::vector<std::string> cached_records = runGame(nn_evaluation_cache);
+    int num_mismatched_moves = 0;
+    for (size_t i = 0; i < records.size() && i < cached_records.size(); ++i) {
+        if (records[i] == cached_records[i]) { continue; }
+        if (num_mismatched_moves++ == 0) {
+            std::cout << "first mismatch at move " << i << ":" << std::endl
+                      << "  " << records[i] << std::endl
+                      << "  " << cached_records[i] << std::endl;
+        }
+    }
+    bool is_key_test_passed = runKeyTest();
+
+    bool is_passed = (records.size() == cached_records.size() && num_mismatched_moves == 0 && is_key_test_passed);
+    std::cout << "moves " << records.size() << " (" << cached_records.size() << " with the cache)"
+              << ", mismatched moves " << num_mismatched_moves
+              << ", key test " << (is_key_test_passed ? "ok" : "failed") << std::endl
+              << nn_evaluation_cache->toString() << std::endl
+              << (is_passed ? "PASSED" : "FAILED") << std::endl;
+    return is_passed;
+}
+
+std::vector<std::string> NNEvaluationCacheTest::runGame(const std::shared_ptr<NNEvaluationCache>& nn_evaluation_cache)
+{
+    std::shared_ptr<Network> network = createNetwork(config::nn_file_name, -1);
+    uint64_t tree_node_size = static_cast<uint64_t>(config::actor_num_simulation + 1) * network->getActionSize();
+    std::shared_ptr<BaseActor> actor = createActor(tree_node_size, network);
+    if (nn_evaluation_cache) { actor->setNNEvaluationCache(nn_evaluation_cache); }
+    utils::Random::seed(config::program_seed);
+    actor->reset();
+
+    // move number, action, and the encoded search statistics of each search
+    std::vector<std::string> records;
+    for (int move = 0; move < num_moves_ && !actor->isEnvTerminal(); ++move) {
+        Action action = actor->think(true, false);
+        std::ostringstream oss;
+        oss << move << " " << action.getActionID() << " " << actor->getSearchStatistics().encode();
+        records.push_back(oss.str());
+        if (actor->isResign()) { break; }
+    }
+    return records;
+}
+
+bool NNEvaluationCacheTest::runKeyTest()
+{
+    std::shared_ptr<AlphaZeroNetwork> network = std::static_pointer_cast<AlphaZeroNetwork>(createNetwork(config::nn_file_name, -1));
+    Environment env;
+    env.reset();
+    std::vector<float> features = env.getFeatures();
+    network->pushBack(features);
+    std::shared_ptr<NetworkOutput> network_output = network->forward()[0];
+
+    NNEvaluationCache nn_evaluation_cache(kTestCacheSize);
+    bool is_passed = true;
+
+    // an output evaluated before a clear, i.e., by the previous model, is not stored
+    NNEvaluationCache::Key stale_key = nn_evaluation_cache.getKey(features);
+    nn_evaluation_cache.clear();
+    nn_evaluation_cache.store(stale_key, network_output);
+    is_passed &= (nn_evaluation_cache.lookup(nn_evaluation_cache.getKey(features)) == nullptr);
+
+    // an output evaluated by the current model is found, but not by a key that only shares the first hash
+    NNEvaluationCache::Key key = nn_evaluation_cache.getKey(features);
+    nn_evaluation_cache.store(key, network_output);
+    is_passed &= (nn_evaluation_cache.lookup(key) == network_output);
+    NNEvaluationCache::Key collided_key = key;
+    collided_key.verification_key_ ^= 1;
+    is_passed &= (nn_evaluation_cache.lookup(collided_key) == nullptr);
+    return is_passed;
+}
+
+} // namespace minizero::actor
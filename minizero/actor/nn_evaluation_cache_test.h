@@ -0,0 +1,33 @@
+#pragma once
+
+#include "base_actor.h"
+#include "nn_evaluation_cache.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace minizero::actor {
+
+/*
+ * NNEvaluationCacheTest plays the same game twice from a fixed seed on cpu, without and with the evaluation cache,
+ * and checks that every search gives a bit-identical decision, distribution, and value
+ * the searches evaluate one leaf per batch, so that the network outputs do not depend on the batch composition
+ * it also checks that a hit is verified by the second key, and that outputs keyed before a clear are not stored
+ */
+class NNEvaluationCacheTest {
+public:
+    NNEvaluationCacheTest(int num_moves)
+        : num_moves_(num_moves)
+    {
+    }
+
+    bool run();
+
+private:
+    std::vector<std::string> runGame(const std::shared_ptr<NNEvaluationCache>& nn_evaluation_cache);
+    bool runKeyTest();
+
+    int num_moves_;
+};
+
+} // namespace minizero::actor
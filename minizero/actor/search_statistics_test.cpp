@@ -0,0 +1,128 @@
+#include "search_statistics_test.h"
+#include "environment.h"
+#include "random.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace minizero::actor {
+
+using namespace minizero::utils;
+
+bool SearchStatisticsTest::run()
+{
+    bool is_round_trip_passed = runRoundTrip();
+    bool is_malformed_passed = runMalformed();
+    bool is_record_passed = runRecord();
+
+    bool is_passed = (is_round_trip_passed && is_malformed_passed && is_record_passed);
+    std::cout << "round trip " << (is_round_trip_passed ? "ok" : "failed")
+              << ", malformed strings " << (is_malformed_passed ? "ok" : "failed")
+              << ", record " << (is_record_passed ? "ok" : "failed") << std::endl
+              << (is_passed ? "PASSED" : "FAILED") << std::endl;
+    return is_passed;
+}
+
+bool SearchStatisticsTest::runRoundTrip()
+{
+    int num_failures = 0;
+    for (int iteration = 0; iteration < num_iterations_; ++iteration) {
+        SearchStatistics search_statistics = randomSearchStatistics(UINT16_MAX, iteration % 2 == 0);
+        std::string encoded = search_statistics.encode();
+        SearchStatistics decoded;
+        bool is_matched = decoded.decode(encoded);
+        is_matched &= (decoded.distribution_ == search_statistics.distribution_ && decoded.value_ == search_statistics.value_ && decoded.reward_ == search_statistics.reward_);
+
+        // the string is kept in an sgf property, so it must not contain characters with a meaning in sgf
+        is_matched &= std::all_of(encoded.begin(), encoded.end(), [](char c) { return std::isalnum(static_cast<unsigned char>(c)) || c == '+' || c == '/' || c == '='; });
+        if (!is_matched && num_failures++ == 0) { std::cout << "round trip failed for " << encoded << std::endl; }
+    }
+    return num_failures == 0;
+}
+
+bool SearchStatisticsTest::runMalformed()
+{
+    SearchStatistics search_statistics = randomSearchStatistics(UINT16_MAX, true);
+    search_statistics.distribution_.push_back({0, 1.0f}); // at least one entry, so that removing a base64 block truncates the binary
+    std::string encoded = search_statistics.encode();
+    SearchStatistics decoded;
+    bool is_passed = !decoded.decode("");
+    is_passed &= !decoded.decode(encoded.substr(0, encoded.size() - 1));
+    is_passed &= !decoded.decode(encoded.substr(0, encoded.size() - 4));
+    is_passed &= !decoded.decode(encoded + "AAAA");
+    return is_passed;
+}
+
+bool SearchStatisticsTest::runRecord()
+{
+    // play a random game, recording random statistics over the legal actions of each position
+    Environment env;
+    env.reset();
+    std::vector<SearchStatistics> search_statistics_history;
+    std::vector<std::vector<std::pair<std::string, std::string>>> action_info_history;
+    while (!env.isTerminal() && static_cast<int>(search_statistics_history.size()) < num_iterations_) {
+        std::vector<Action> legal_actions = env.getLegalActions();
+        SearchStatistics search_statistics = randomSearchStatistics(0, search_statistics_history.size() % 2 == 0);
+        for (const auto& action : legal_actions) {
+            if (Random::randInt() % 2 == 0) { continue; }
+            float count = (search_statistics_history.size() % 2 == 0 ? 1 + Random::randInt() % 1000 : Random::randReal(1000.0f) + 0.001f);
+            search_statistics.distribution_.push_back({action.getActionID(), count});
+        }
+        if (search_statistics.distribution_.empty()) { search_statistics.distribution_.push_back({legal_actions[0].getActionID(), 1.0f}); }
+        search_statistics_history.push_back(search_statistics);
+        action_info_history.push_back({{"S", search_statistics.encode()}});
+        env.act(legal_actions[Random::randInt() % legal_actions.size()]);
+    }
+
+    // the record is read back as the learner does
+    EnvironmentLoader env_loader;
+    env_loader.loadFromEnvironment(env, action_info_history);
+    EnvironmentLoader loaded_env_loader;
+    if (!loaded_env_loader.loadFromString(env_loader.toString())) {
+        std::cout << "failed to load the record" << std::endl;
+        return false;
+    }
+    int num_failures = 0;
+    for (size_t pos = 0; pos < search_statistics_history.size(); ++pos) {
+        SearchStatistics& search_statistics = search_statistics_history[pos];
+        std::vector<float> policy(loaded_env_loader.getPolicySize(), 0.0f);
+        float total = 0.0f;
+        for (const auto& p : search_statistics.distribution_) {
+            policy[p.first] = p.second;
+            total += p.second;
+        }
+        for (auto& p : policy) { p /= total; }
+        SearchStatistics loaded;
+        bool is_matched = (loaded_env_loader.getPolicy(pos) == policy);
+        is_matched &= loaded_env_loader.getSearchStatistics(pos, loaded);
+        is_matched &= (loaded.distribution_ == search_statistics.distribution_ && loaded.value_ == search_statistics.value_ && loaded.reward_ == search_statistics.reward_);
+
+        // the value updated by the learner is written back to the binary field
+        search_statistics.value_ = Random::randReal(2.0f) - 1.0f;
+        is_matched &= loaded_env_loader.setValue(pos, search_statistics.value_);
+        is_matched &= (loaded_env_loader.getSearchStatistics(pos, loaded) && loaded.value_ == search_statistics.value_ && loaded.distribution_ == search_statistics.distribution_);
+        if (!is_matched && num_failures++ == 0) { std::cout << "record mismatch at move " << pos << std::endl; }
+    }
+    return !search_statistics_history.empty() && num_failures == 0;
+}
+
+SearchStatistics SearchStatisticsTest::randomSearchStatistics(int max_action_id, bool is_integer_count) const
+{
+    // visit counts are small integers, other counts (e.g., gumbel policies) are arbitrary floats
+    SearchStatistics search_statistics;
+    int num_entries = (max_action_id > 0 ? Random::randInt() % 400 : 0);
+    for (int i = 0; i < num_entries; ++i) {
+        int action_id = Random::randInt() % (max_action_id + 1);
+        float count = (is_integer_count ? Random::randInt() % (UINT16_MAX + 1) : static_cast<float>(Random::randReal(1e6) - 5e5));
+        search_statistics.distribution_.push_back({action_id, count});
+    }
+    search_statistics.value_ = Random::randReal(2.0f) - 1.0f;
+    search_statistics.reward_ = Random::randReal(100.0f) - 50.0f;
+    return search_statistics;
+}
+
+} // namespace minizero::actor
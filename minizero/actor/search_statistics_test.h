@@ -0,0 +1,31 @@
+#pragma once
+
+#include "search_statistics.h"
+
+namespace minizero::actor {
+
+/*
+ * SearchStatisticsTest checks the binary search statistics recorded with actor_record_binary_search_statistics:
+ * random statistics with visit counts and with float counts are encoded and decoded back exactly,
+ * malformed strings are rejected, and a record written with the binary field is read back by the environment loader
+ * as the same policy and statistics, also after the value is updated by the learner
+ */
+class SearchStatisticsTest {
+public:
+    SearchStatisticsTest(int num_iterations)
+        : num_iterations_(num_iterations)
+    {
+    }
+
+    bool run();
+
+private:
+    bool runRoundTrip();
+    bool runMalformed();
+    bool runRecord();
+    utils::SearchStatistics randomSearchStatistics(int max_action_id, bool is_integer_count) const;
+
+    int num_iterations_;
+};
+
+} // namespace minizero::actor
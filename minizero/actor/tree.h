@@ -1,32 +1,48 @@
 #pragma once
 
+#include <algorithm>
 #include <cassert>
+#include <memory>
 #include <string>
 #include <vector>
 
 namespace minizero::actor {
 
-template <class Data>
-class TreeData {
+/*
+ * TreeSlabData stores a fixed-size float array per tree node (e.g., MuZero hidden states) in one contiguous slab
+ * reset keeps the slab, so that later searches write into the storage of previous ones
+ * pointers returned by getData are only valid until the next store
+ */
+class TreeSlabData {
 public:
-    TreeData() { reset(); }
+    TreeSlabData()
+        : data_size_(0)
+    {
+        reset();
+    }
 
-    inline void reset() { data_.clear(); }
-    inline int store(const Data& data)
+    inline void reset() { size_ = 0; }
+    inline int store(const float* data, int data_size)
     {
-        int index = data_.size();
-        data_.push_back(data);
+        assert(size_ == 0 || data_size == data_size_);
+        data_size_ = data_size;
+        int index = size_++;
+        if (slab_.size() < static_cast<size_t>(size_) * data_size_) { slab_.resize(std::max(slab_.size() * 2, static_cast<size_t>(size_) * data_size_)); }
+        std::copy(data, data + data_size_, slab_.begin() + static_cast<size_t>(index) * data_size_);
         return index;
     }
-    inline const Data& getData(int index) const
+    inline const float* getData(int index) const
     {
         assert(index >= 0 && index < size());
-        return data_[index];
+        return slab_.data() + static_cast<size_t>(index) * data_size_;
     }
-    inline int size() const { return data_.size(); }
+    inline int size() const { return size_; }
+    inline int getDataSize() const { return data_size_; }
 
 private:
-    std::vector<Data> data_;
+    int size_;
+    int data_size_;
+    std::vector<float> slab_;
 };
 
 class TreeNode {
@@ -52,30 +68,51 @@ protected:
     TreeNode* first_child_;
 };
 
+const uint64_t kTreeNodeBlockSize = 4096;
+
+/*
+ * Tree allocates its nodes from blocks created on demand, instead of reserving the worst case (tree_node_size) up front
+ * blocks are kept across searches, and reset only rewinds the allocation to the beginning of the first block
+ * children of a node are always contiguous in one block
+ */
 class Tree {
 public:
     Tree(uint64_t tree_node_size)
         : tree_node_size_(tree_node_size),
-          nodes_(nullptr)
+          num_reserved_nodes_(0),
+          root_(nullptr)
     {
         assert(tree_node_size >= 0);
     }
 
     inline void reset()
     {
-        if (!nodes_) { nodes_ = createTreeNodes(1 + tree_node_size_); }
+        if (blocks_.empty()) { addBlock(std::min(kTreeNodeBlockSize, 1 + tree_node_size_)); }
+        current_block_ = 0;
+        current_block_offset_ = 1;
         current_node_size_ = 1;
-        getRootNode()->reset();
+        root_ = blocks_[0].nodes_.get();
+        root_->reset();
     }
 
     inline TreeNode* allocateNodes(int size)
     {
         assert(current_node_size_ + size <= 1 + tree_node_size_);
-        TreeNode* node = getNodeIndex(current_node_size_);
+        while (current_block_offset_ + size > blocks_[current_block_].size_) {
+            // the rest of the current block is left unused for this search
+            current_block_offset_ = 0;
+            if (++current_block_ == blocks_.size()) { addBlock(std::max<uint64_t>(kTreeNodeBlockSize, size)); }
+        }
+        TreeNode* node = getNodeIndex(blocks_[current_block_].nodes_.get(), current_block_offset_);
+        current_block_offset_ += size;
         current_node_size_ += size;
         return node;
     }
 
+    inline uint64_t getNumUsedNodes() const { return current_node_size_; }
+    inline uint64_t getNumReservedNodes() const { return num_reserved_nodes_; }
+    inline uint64_t getMaxNumNodes() const { return 1 + tree_node_size_; }
+
     std::string toString(const std::string& env_string)
     {
         assert(!env_string.empty() && env_string.back() == ')');
@@ -109,16 +146,32 @@ public:
         return oss.str();
     }
 
-    inline TreeNode* getRootNode() { return &nodes_[0]; }
-    inline const TreeNode* getRootNode() const { return &nodes_[0]; }
+    inline TreeNode* getRootNode() { return root_; }
+    inline const TreeNode* getRootNode() const { return root_; }
 
 protected:
-    virtual TreeNode* createTreeNodes(uint64_t tree_node_size) = 0;
-    virtual TreeNode* getNodeIndex(int index) = 0;
+    class TreeNodeBlock {
+    public:
+        std::shared_ptr<TreeNode> nodes_;
+        uint64_t size_;
+    };
+
+    inline void addBlock(uint64_t size)
+    {
+        blocks_.push_back({createTreeNodes(size), size});
+        num_reserved_nodes_ += size;
+    }
+
+    virtual std::shared_ptr<TreeNode> createTreeNodes(uint64_t tree_node_size) = 0;
+    virtual TreeNode* getNodeIndex(TreeNode* nodes, uint64_t index) = 0;
 
     uint64_t tree_node_size_;
     uint64_t current_node_size_;
-    TreeNode* nodes_;
+    uint64_t current_block_;
+    uint64_t current_block_offset_;
+    uint64_t num_reserved_nodes_;
+    TreeNode* root_;
+    std::vector<TreeNodeBlock> blocks_;
 };
 
 } // namespace minizero::actor
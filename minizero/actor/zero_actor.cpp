@@ -4,6 +4,7 @@
 #include <algorithm>
 #include <memory>
 #include <tuple>
+#include <type_traits>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -13,6 +14,12 @@ namespace minizero::actor {
 using namespace minizero;
 using namespace network;
 
+// only environments with position hash keys (e.g., go and rubiks) support transpositions
+template <class Env, class = void>
+class HasHashKey : public std::false_type {};
+template <class Env>
+class HasHashKey<Env, std::void_t<decltype(std::declval<const Env&>().getHashKey())>> : public std::true_type {};
+
 void MCTSSearchData::clear()
 {
     search_info_ = "";
@@ -30,11 +37,14 @@ void ZeroActor::resetSearch()
 {
     BaseActor::resetSearch();
     mcts_search_data_.node_path_.clear();
+    is_full_search_ = (is_thinking_ || config::actor_playout_cap_full_search_ratio >= 1.0f || utils::Random::randReal() < config::actor_playout_cap_full_search_ratio);
+    if (!is_full_search_) { getMCTS()->setNumSimulationLimit(std::min(config::actor_playout_cap_fast_num_simulation, config::actor_num_simulation)); }
     getMCTS()->getRootNode()->setAction(Action(-1, env::getPreviousPlayer(env_.getTurn(), env_.getNumPlayer())));
 }
 
 Action ZeroActor::think(bool with_play /*= false*/, bool display_board /*= false*/)
 {
+    is_thinking_ = true;
     resetSearch();
     boost::posix_time::ptime start_ptime = utils::TimeSystem::getLocalTime();
     while (!isSearchDone()) {
@@ -43,6 +53,7 @@ Action ZeroActor::think(bool with_play /*= false*/, bool display_board /*= false
         if (config::actor_mcts_think_time_limit > 0 && spent_million_second >= config::actor_mcts_think_time_limit * 1000) { break; }
     }
     if (!isSearchDone()) { handleSearchDone(); }
+    is_thinking_ = false;
     if (with_play) { act(getSearchAction()); }
     if (display_board) { std::cerr << env_.toString() << mcts_search_data_.search_info_ << std::endl; }
     return getSearchAction();
@@ -50,11 +61,32 @@ Action ZeroActor::think(bool with_play /*= false*/, bool display_board /*= false
 
 void ZeroActor::beforeNNEvaluation()
 {
-    mcts_search_data_.node_path_ = selection();
+    selection();
     if (alphazero_network_) {
-        Environment env_transition = getEnvironmentTransition(mcts_search_data_.node_path_);
-        feature_rotation_ = config::actor_use_random_rotation_features ? static_cast<utils::Rotation>(utils::Random::randInt() % static_cast<int>(utils::Rotation::kRotateSize)) : utils::Rotation::kRotationNone;
-        nn_evaluation_batch_id_ = alphazero_network_->pushBack(env_transition.getFeatures(feature_rotation_));
+        while (true) {
+            const Environment& env_transition = getEnvironmentTransition(mcts_search_data_.node_path_);
+            if (evaluateByTransposition(env_transition)) {
+                selection();
+                continue;
+            }
+
+            feature_rotation_ = config::actor_use_random_rotation_features ? static_cast<utils::Rotation>(utils::Random::randInt() % static_cast<int>(utils::Rotation::kRotateSize)) : utils::Rotation::kRotationNone;
+            std::vector<float> features = env_transition.getFeatures(feature_rotation_);
+            if (nn_evaluation_cache_) {
+                // a cached evaluation is applied immediately, the batch index stays -1 so that nothing is waited for the network
+                nn_evaluation_cache_key_ = nn_evaluation_cache_->getKey(features);
+                std::shared_ptr<NetworkOutput> network_output = nn_evaluation_cache_->lookup(nn_evaluation_cache_key_);
+                if (network_output) {
+                    nn_evaluation_batch_id_ = -1;
+                    afterNNEvaluation(network_output);
+                    if (isSearchDone()) { return; }
+                    selection();
+                    continue;
+                }
+            }
+            nn_evaluation_batch_id_ = alphazero_network_->pushBack(std::move(features));
+            break;
+        }
     } else if (muzero_network_) {
         if (getMCTS()->getNumSimulation() == 0) { // initial inference for root node
             nn_evaluation_batch_id_ = muzero_network_->pushBackInitialData(env_.getFeatures());
@@ -63,7 +95,7 @@ void ZeroActor::beforeNNEvaluation()
             MCTSNode* leaf_node = node_path.back();
             MCTSNode* parent_node = node_path[node_path.size() - 2];
             assert(parent_node && parent_node->getHiddenStateDataIndex() != -1);
-            const std::vector<float>& hidden_state = getMCTS()->getTreeHiddenStateData().getData(parent_node->getHiddenStateDataIndex()).hidden_state_;
+            const float* hidden_state = getMCTS()->getTreeHiddenStateData().getData(parent_node->getHiddenStateDataIndex());
             nn_evaluation_batch_id_ = muzero_network_->pushBackRecurrentData(hidden_state, env_.getActionFeatures(leaf_node->getAction()));
         }
     } else {
@@ -76,11 +108,14 @@ void ZeroActor::afterNNEvaluation(const std::shared_ptr<NetworkOutput>& network_
     const std::vector<MCTSNode*>& node_path = mcts_search_data_.node_path_;
     MCTSNode* leaf_node = node_path.back();
     if (alphazero_network_) {
-        Environment env_transition = getEnvironmentTransition(node_path);
+        const Environment& env_transition = getEnvironmentTransition(node_path);
         if (!env_transition.isTerminal()) {
             std::shared_ptr<AlphaZeroNetworkOutput> alphazero_output = std::static_pointer_cast<AlphaZeroNetworkOutput>(network_output);
+            if (nn_evaluation_cache_ && nn_evaluation_batch_id_ >= 0) { nn_evaluation_cache_->store(nn_evaluation_cache_key_, network_output); }
             getMCTS()->expand(leaf_node, calculateAlphaZeroActionPolicy(env_transition, alphazero_output, feature_rotation_));
             getMCTS()->backup(node_path, alphazero_output->value_, env_transition.getReward());
+            uint64_t hash_key = 0;
+            if (config::actor_mcts_use_transposition && leaf_node != getMCTS()->getRootNode() && getHashKey(env_transition, hash_key)) { getMCTS()->getTranspositionTable().emplace(hash_key, leaf_node); }
         } else {
             getMCTS()->backup(node_path, env_transition.getEvalScore(), env_transition.getReward());
         }
@@ -88,11 +123,12 @@ void ZeroActor::afterNNEvaluation(const std::shared_ptr<NetworkOutput>& network_
         std::shared_ptr<MuZeroNetworkOutput> muzero_output = std::static_pointer_cast<MuZeroNetworkOutput>(network_output);
         getMCTS()->expand(leaf_node, calculateMuZeroActionPolicy(leaf_node, muzero_output));
         getMCTS()->backup(node_path, muzero_output->value_, muzero_output->reward_);
-        leaf_node->setHiddenStateDataIndex(getMCTS()->getTreeHiddenStateData().store(HiddenStateData(muzero_output->hidden_state_)));
+        const int hidden_state_size = muzero_network_->getNumHiddenChannels() * muzero_network_->getHiddenChannelHeight() * muzero_network_->getHiddenChannelWidth();
+        leaf_node->setHiddenStateDataIndex(getMCTS()->getTreeHiddenStateData().store(muzero_output->hidden_state_, hidden_state_size));
     } else {
         assert(false);
     }
-    if (leaf_node == getMCTS()->getRootNode()) { addNoiseToNodeChildren(leaf_node); }
+    if (leaf_node == getMCTS()->getRootNode() && is_full_search_) { addNoiseToNodeChildren(leaf_node); }
     if (isSearchDone()) { handleSearchDone(); }
     if (config::actor_use_gumbel) { gumbel_zero_.sequentialHalving(getMCTS()); }
 }
@@ -115,8 +151,21 @@ void ZeroActor::setNetwork(const std::shared_ptr<network::Network>& network)
 std::vector<std::pair<std::string, std::string>> ZeroActor::getActionInfo() const
 {
     // ignore recording mcts action info if there is no search
-    if (getMCTS()->getRootNode()->getCount() > 0) { return BaseActor::getActionInfo(); }
-    return {};
+    if (getMCTS()->getRootNode()->getCount() == 0) { return {}; }
+
+    // fast searches of playout cap randomization are marked, so that the learner skips them as policy targets
+    std::vector<std::pair<std::string, std::string>> action_info = BaseActor::getActionInfo();
+    if (!is_full_search_) { action_info.push_back({"PC", "0"}); }
+    return action_info;
+}
+
+utils::SearchStatistics ZeroActor::getSearchStatistics() const
+{
+    utils::SearchStatistics search_statistics;
+    search_statistics.distribution_ = (config::actor_use_gumbel ? gumbel_zero_.getMCTSPolicyDistribution(getMCTS()) : getMCTS()->getSearchDistribution());
+    search_statistics.value_ = getMCTS()->getRootNode()->getMean();
+    search_statistics.reward_ = env_.getReward();
+    return search_statistics;
 }
 
 std::string ZeroActor::getEnvReward() const
@@ -130,32 +179,47 @@ void ZeroActor::step()
 {
     assert(alphazero_network_ || muzero_network_);
     int num_simulation = getMCTS()->getNumSimulation();
-    int num_simulation_left = config::actor_num_simulation + 1 - num_simulation;
-    int batch_size = std::min(config::actor_mcts_think_batch_size,
-                              (alphazero_network_ || num_simulation > 0) ? num_simulation_left : 1 /* initial inference for root node */);
-    assert(batch_size > 0);
+    int max_batch_size = (alphazero_network_ || num_simulation > 0) ? config::actor_mcts_think_batch_size : 1 /* initial inference for root node */;
 
-    std::vector<std::tuple<int, utils::Rotation, decltype(mcts_search_data_.node_path_)>> batch_queries; // batch id, rotation, search path
-    for (int batch_id = 0; batch_id < batch_size; batch_id++) {
+    // the queries are kept in slots reused across steps, so that their search paths keep the allocated storage
+    // the remaining simulations are recomputed for each entry, since transposition hits complete simulations while the batch is collected
+    int num_batch_queries = 0;
+    int batch_size = 0;
+    for (int batch_id = 0; batch_id < max_batch_size; batch_id++) {
+        if (getMCTS()->getNumSimulationLimit() + 1 - getMCTS()->getNumSimulation() - batch_id <= 0) { break; }
+        num_pending_simulations_ = batch_id;
         beforeNNEvaluation();
+        if (nn_evaluation_batch_id_ < 0) { break; } // the search is finished by cached evaluations
         assert(nn_evaluation_batch_id_ == batch_id);
+        ++batch_size;
         if (mcts_search_data_.node_path_.back()->getVirtualLoss() == 0) {
-            batch_queries.emplace_back(nn_evaluation_batch_id_, feature_rotation_, mcts_search_data_.node_path_);
+            if (static_cast<int>(batch_queries_.size()) == num_batch_queries) { batch_queries_.emplace_back(); }
+            batch_queries_[num_batch_queries++] = std::tie(nn_evaluation_batch_id_, feature_rotation_, nn_evaluation_cache_key_, mcts_search_data_.node_path_);
         }
         for (auto node : mcts_search_data_.node_path_) { node->addVirtualLoss(); }
     }
+    num_pending_simulations_ = 0;
+    if (batch_size == 0) { return; }
+
     auto network_output = alphazero_network_ ? alphazero_network_->forward()
                                              : (num_simulation == 0 ? muzero_network_->initialInference() : muzero_network_->recurrentInference());
-    for (auto& query : batch_queries) {
-        nn_evaluation_batch_id_ = std::get<0>(query);
-        feature_rotation_ = std::get<1>(query);
-        mcts_search_data_.node_path_ = std::get<2>(query);
-        afterNNEvaluation(network_output[nn_evaluation_batch_id_]);
+    for (int i = 0; i < num_batch_queries; ++i) {
+        std::tie(nn_evaluation_batch_id_, feature_rotation_, nn_evaluation_cache_key_, mcts_search_data_.node_path_) = batch_queries_[i];
+        if (!isSearchDone()) { afterNNEvaluation(network_output[nn_evaluation_batch_id_]); } // the rest of the batch is dropped after early termination
         auto virtual_loss = mcts_search_data_.node_path_.back()->getVirtualLoss();
         for (auto node : mcts_search_data_.node_path_) { node->removeVirtualLoss(virtual_loss); }
     }
 }
 
+void ZeroActor::selection()
+{
+    if (config::actor_use_gumbel) {
+        gumbel_zero_.selection(getMCTS(), mcts_search_data_.node_path_);
+    } else {
+        getMCTS()->select(mcts_search_data_.node_path_);
+    }
+}
+
 void ZeroActor::handleSearchDone()
 {
     mcts_search_data_.selected_node_ = decideActionNode();
@@ -168,13 +232,33 @@ void ZeroActor::handleSearchDone()
         << " (" << action.getActionID() << ")"
         << ", reward: " << env_.getReward()
         << ", player: " << env::playerToChar(action.getPlayer());
+    if (!is_full_search_) { oss << ", fast search: " << getMCTS()->getNumSimulationLimit(); }
+    if (config::actor_mcts_use_transposition) { oss << ", transposition hits: " << getMCTS()->getNumTranspositionHits(); }
+    if (config::actor_mcts_early_termination) {
+        int num_saved_simulations = (isBestActionDecided() ? getMCTS()->getNumSimulationLimit() + 1 - getMCTS()->getNumSimulation() : 0);
+        ++num_searches_;
+        num_saved_simulations_ += num_saved_simulations;
+        oss << ", saved simulations: " << num_saved_simulations << " (average " << num_saved_simulations_ * 1.0f / num_searches_ << ")";
+    }
     if (config::actor_mcts_value_rescale) { oss << ", value bound: (" << getMCTS()->getTreeValueBound().begin()->first << ", " << getMCTS()->getTreeValueBound().rbegin()->first << ")"; }
     oss << std::endl
         << "  root node info: " << getMCTS()->getRootNode()->toString() << std::endl
-        << "action node info: " << mcts_search_data_.selected_node_->toString() << std::endl;
+        << "action node info: " << mcts_search_data_.selected_node_->toString() << std::endl
+        << "tree memory info: " << getTreeMemoryInfo() << std::endl;
     mcts_search_data_.search_info_ = oss.str();
 }
 
+std::string ZeroActor::getTreeMemoryInfo() const
+{
+    // nodes are reserved in blocks when the tree grows, the worst case is the size reserved up front before
+    auto to_mb = [](uint64_t num_nodes) { return num_nodes * sizeof(MCTSNode) / (1024.0f * 1024.0f); };
+    std::ostringstream oss;
+    oss << "used " << getMCTS()->getNumUsedNodes() << " nodes (" << to_mb(getMCTS()->getNumUsedNodes()) << " MB)"
+        << ", reserved " << getMCTS()->getNumReservedNodes() << " nodes (" << to_mb(getMCTS()->getNumReservedNodes()) << " MB)"
+        << ", worst case " << getMCTS()->getMaxNumNodes() << " nodes (" << to_mb(getMCTS()->getMaxNumNodes()) << " MB)";
+    return oss.str();
+}
+
 MCTSNode* ZeroActor::decideActionNode()
 {
     if (config::actor_use_gumbel) {
@@ -212,10 +296,11 @@ void ZeroActor::addNoiseToNodeChildren(MCTSNode* node)
     }
 }
 
-std::vector<MCTS::ActionCandidate> ZeroActor::calculateAlphaZeroActionPolicy(const Environment& env_transition, const std::shared_ptr<network::AlphaZeroNetworkOutput>& alphazero_output, const utils::Rotation& rotation)
+const std::vector<MCTS::ActionCandidate>& ZeroActor::calculateAlphaZeroActionPolicy(const Environment& env_transition, const std::shared_ptr<network::AlphaZeroNetworkOutput>& alphazero_output, const utils::Rotation& rotation)
 {
     assert(alphazero_network_);
-    std::vector<MCTS::ActionCandidate> action_candidates;
+    std::vector<MCTS::ActionCandidate>& action_candidates = action_candidates_;
+    action_candidates.clear();
     for (size_t action_id = 0; action_id < alphazero_output->policy_.size(); ++action_id) {
         Action action(action_id, env_transition.getTurn());
         if (!env_transition.isLegalAction(action)) { continue; }
@@ -228,10 +313,11 @@ std::vector<MCTS::ActionCandidate> ZeroActor::calculateAlphaZeroActionPolicy(con
     return action_candidates;
 }
 
-std::vector<MCTS::ActionCandidate> ZeroActor::calculateMuZeroActionPolicy(MCTSNode* leaf_node, const std::shared_ptr<network::MuZeroNetworkOutput>& muzero_output)
+const std::vector<MCTS::ActionCandidate>& ZeroActor::calculateMuZeroActionPolicy(MCTSNode* leaf_node, const std::shared_ptr<network::MuZeroNetworkOutput>& muzero_output)
 {
     assert(muzero_network_);
-    std::vector<MCTS::ActionCandidate> action_candidates;
+    std::vector<MCTS::ActionCandidate>& action_candidates = action_candidates_;
+    action_candidates.clear();
     env::Player turn = leaf_node->getAction().nextPlayer();
     for (size_t action_id = 0; action_id < muzero_output->policy_.size(); ++action_id) {
         const Action action(action_id, turn);
@@ -244,11 +330,65 @@ std::vector<MCTS::ActionCandidate> ZeroActor::calculateMuZeroActionPolicy(MCTSNo
     return action_candidates;
 }
 
-Environment ZeroActor::getEnvironmentTransition(const std::vector<MCTSNode*>& node_path)
+const Environment& ZeroActor::getEnvironmentTransition(const std::vector<MCTSNode*>& node_path)
 {
-    Environment env = env_;
-    for (size_t i = 1; i < node_path.size(); ++i) { env.act(node_path[i]->getAction()); }
-    return env;
+    // the transition is rebuilt in place, the copy assignment reuses the storage allocated by previous simulations
+    env_transition_ = env_;
+    for (size_t i = 1; i < node_path.size(); ++i) { env_transition_.act(node_path[i]->getAction()); }
+    return env_transition_;
+}
+
+bool ZeroActor::evaluateByTransposition(const Environment& env_transition)
+{
+    // reuse the network evaluation of the first node expanded with the same position, instead of evaluating it again
+    // the last simulation, counting those pending in the current batch, is always left to the network, so that the search is finished in afterNNEvaluation
+    uint64_t hash_key = 0;
+    if (!config::actor_mcts_use_transposition || env_transition.isTerminal() || !getHashKey(env_transition, hash_key)) { return false; }
+    if (getMCTS()->getNumSimulation() + num_pending_simulations_ + 1 >= getMCTS()->getNumSimulationLimit() + 1) { return false; }
+
+    auto it = getMCTS()->getTranspositionTable().find(hash_key);
+    if (it == getMCTS()->getTranspositionTable().end() || it->second->isLeaf()) { return false; }
+    const MCTSNode* node = it->second;
+    if (node->getChild(0)->getAction().getPlayer() != env_transition.getTurn()) { return false; } // hash keys may ignore the turn, e.g., positional ko rule
+
+    // the legal actions may still differ due to the history, e.g., superko
+    std::vector<MCTS::ActionCandidate>& action_candidates = action_candidates_;
+    action_candidates.clear();
+    for (int i = 0; i < node->getNumChildren(); ++i) {
+        const MCTSNode* child = node->getChild(i);
+        if (!env_transition.isLegalAction(child->getAction())) { continue; }
+        action_candidates.push_back(MCTS::ActionCandidate(child->getAction(), child->getPolicy(), child->getPolicyLogit()));
+    }
+    if (action_candidates.empty()) { return false; }
+
+    const std::vector<MCTSNode*>& node_path = mcts_search_data_.node_path_;
+    getMCTS()->expand(node_path.back(), action_candidates);
+    getMCTS()->backup(node_path, node->getValue(), env_transition.getReward());
+    getMCTS()->addTranspositionHit();
+    if (config::actor_use_gumbel) { gumbel_zero_.sequentialHalving(getMCTS()); }
+    return true;
+}
+
+bool ZeroActor::isBestActionDecided() const
+{
+    // the action selected by count cannot change once the lead of the most visited root child exceeds the remaining simulations
+    // self-play with noise always runs all simulations, since its counts are also the policy targets for training
+    if (!config::actor_mcts_early_termination || !config::actor_select_action_by_count || config::actor_use_gumbel) { return false; }
+    if (!is_thinking_ && (!config::actor_mcts_early_termination_in_self_play || config::actor_use_dirichlet_noise || config::actor_use_gumbel_noise)) { return false; }
+    if (getMCTS()->getRootNode()->isLeaf()) { return false; }
+
+    int num_simulation_left = getMCTS()->getNumSimulationLimit() + 1 - getMCTS()->getNumSimulation();
+    return getMCTS()->getMaxCountLead(getMCTS()->getRootNode()) > num_simulation_left + config::actor_mcts_early_termination_margin;
+}
+
+bool ZeroActor::getHashKey(const Environment& env, uint64_t& hash_key) const
+{
+    if constexpr (HasHashKey<Environment>::value) {
+        hash_key = static_cast<uint64_t>(env.getHashKey());
+        return true;
+    } else {
+        return false;
+    }
 }
 
 } // namespace minizero::actor
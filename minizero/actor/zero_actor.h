@@ -7,6 +7,7 @@
 #include "muzero_network.h"
 #include <memory>
 #include <string>
+#include <tuple>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -28,6 +29,13 @@ public:
     {
         alphazero_network_ = nullptr;
         muzero_network_ = nullptr;
+        nn_evaluation_cache_ = nullptr;
+        is_thinking_ = false;
+        is_full_search_ = true;
+        num_searches_ = 0;
+        num_saved_simulations_ = 0;
+        num_pending_simulations_ = 0;
+        mcts_search_data_.node_path_.reserve(config::actor_num_simulation + 1); // the longest search path
     }
 
     void reset() override;
@@ -35,12 +43,14 @@ public:
     Action think(bool with_play = false, bool display_board = false) override;
     void beforeNNEvaluation() override;
     void afterNNEvaluation(const std::shared_ptr<network::NetworkOutput>& network_output) override;
-    bool isSearchDone() const override { return getMCTS()->reachMaximumSimulation(); }
+    bool isSearchDone() const override { return getMCTS()->reachMaximumSimulation() || isBestActionDecided(); }
     Action getSearchAction() const override { return mcts_search_data_.selected_node_->getAction(); }
     bool isResign() const override { return enable_resign_ && getMCTS()->isResign(mcts_search_data_.selected_node_); }
     std::string getSearchInfo() const override { return mcts_search_data_.search_info_; }
     void setNetwork(const std::shared_ptr<network::Network>& network) override;
+    void setNNEvaluationCache(const std::shared_ptr<NNEvaluationCache>& nn_evaluation_cache) override { nn_evaluation_cache_ = nn_evaluation_cache; }
     std::shared_ptr<Search> createSearch() override { return std::make_shared<MCTS>(tree_node_size_); }
+    utils::SearchStatistics getSearchStatistics() const override;
     std::shared_ptr<MCTS> getMCTS() { return std::static_pointer_cast<MCTS>(search_); }
     const std::shared_ptr<MCTS> getMCTS() const { return std::static_pointer_cast<MCTS>(search_); }
 
@@ -53,20 +63,34 @@ protected:
     virtual void step();
     virtual void handleSearchDone();
     virtual MCTSNode* decideActionNode();
+    std::string getTreeMemoryInfo() const;
     virtual void addNoiseToNodeChildren(MCTSNode* node);
-    virtual std::vector<MCTSNode*> selection() { return (config::actor_use_gumbel ? gumbel_zero_.selection(getMCTS()) : getMCTS()->select()); }
+    virtual void selection();
 
-    std::vector<MCTS::ActionCandidate> calculateAlphaZeroActionPolicy(const Environment& env_transition, const std::shared_ptr<network::AlphaZeroNetworkOutput>& alphazero_output, const utils::Rotation& rotation);
-    std::vector<MCTS::ActionCandidate> calculateMuZeroActionPolicy(MCTSNode* leaf_node, const std::shared_ptr<network::MuZeroNetworkOutput>& muzero_output);
-    virtual Environment getEnvironmentTransition(const std::vector<MCTSNode*>& node_path);
+    const std::vector<MCTS::ActionCandidate>& calculateAlphaZeroActionPolicy(const Environment& env_transition, const std::shared_ptr<network::AlphaZeroNetworkOutput>& alphazero_output, const utils::Rotation& rotation);
+    const std::vector<MCTS::ActionCandidate>& calculateMuZeroActionPolicy(MCTSNode* leaf_node, const std::shared_ptr<network::MuZeroNetworkOutput>& muzero_output);
+    virtual const Environment& getEnvironmentTransition(const std::vector<MCTSNode*>& node_path);
+    virtual bool evaluateByTransposition(const Environment& env_transition);
+    virtual bool isBestActionDecided() const;
+    bool getHashKey(const Environment& env, uint64_t& hash_key) const;
 
     bool enable_resign_;
+    bool is_thinking_;
+    bool is_full_search_;
+    int num_searches_;
+    long long num_saved_simulations_;
+    int num_pending_simulations_; // simulations already collected in the current batch of step()
     GumbelZero gumbel_zero_;
     uint64_t tree_node_size_;
     MCTSSearchData mcts_search_data_;
+    Environment env_transition_;
+    std::vector<MCTS::ActionCandidate> action_candidates_;
+    std::vector<std::tuple<int, utils::Rotation, NNEvaluationCache::Key, std::vector<MCTSNode*>>> batch_queries_; // batch id, rotation, cache key, search path
     utils::Rotation feature_rotation_;
+    NNEvaluationCache::Key nn_evaluation_cache_key_;
     std::shared_ptr<network::AlphaZeroNetwork> alphazero_network_;
     std::shared_ptr<network::MuZeroNetwork> muzero_network_;
+    std::shared_ptr<NNEvaluationCache> nn_evaluation_cache_;
 };
 
 } // namespace minizero::actor
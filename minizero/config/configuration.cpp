@@ -18,6 +18,11 @@ int actor_mcts_think_batch_size = 1;
 float actor_mcts_think_time_limit = 0;
 bool actor_mcts_value_rescale = false;
 char actor_mcts_value_flipping_player = 'W';
+bool actor_mcts_use_transposition = false;
+bool actor_mcts_early_termination = false;
+int actor_mcts_early_termination_margin = 0;
+bool actor_mcts_early_termination_in_self_play = false;
+int actor_nn_evaluation_cache_size = 0;
 bool actor_select_action_by_count = false;
 bool actor_select_action_by_softmax_count = true;
 float actor_select_action_softmax_temperature = 1.0f;
@@ -32,11 +37,15 @@ int actor_gumbel_sample_size = 16;
 float actor_gumbel_sigma_visit_c = 50;
 float actor_gumbel_sigma_scale_c = 1;
 float actor_resign_threshold = -0.9f;
+float actor_playout_cap_full_search_ratio = 1.0f;
+int actor_playout_cap_fast_num_simulation = 10;
+bool actor_record_binary_search_statistics = false;
 
 // zero parameters
 int zero_num_threads = 4;
 int zero_num_parallel_games = 32;
 int zero_server_port = 9999;
+int zero_server_num_io_threads = 4;
 std::string zero_training_directory = "";
 int zero_num_games_per_iteration = 2000;
 int zero_start_iteration = 0;
@@ -46,6 +55,12 @@ float zero_disable_resign_ratio = 0.1;
 int zero_actor_intermediate_sequence_length = 0;
 std::string zero_actor_ignored_command = "reset_actors";
 bool zero_server_accept_different_model_games = true;
+bool zero_actor_binary_self_play_data = false;
+bool zero_server_compress_self_play_games = false;
+int zero_server_self_play_writer_queue_size = 256;
+int zero_server_self_play_data_queue_size = 256;
+bool zero_server_async_training = false;
+int zero_server_max_model_staleness = 1;
 int zero_display_latest_games = 0;
 
 // learner parameters
@@ -71,11 +86,18 @@ int nn_num_blocks = 1;
 int nn_num_hidden_channels = 256;
 int nn_num_value_hidden_channels = 256;
 std::string nn_type_name = "alphazero";
+int nn_cpu_num_intra_op_threads = 0;
+int nn_cpu_num_inter_op_threads = 0;
+bool nn_cpu_optimize_for_inference = true;
+bool nn_cpu_channels_last = false;
+std::string nn_inference_service_path = "";
+int nn_inference_service_max_batch_size = 1024;
 
 // environment parameters
 int env_board_size = 0;
 std::string env_atari_rom_dir = "/opt/atari57/";
 std::string env_atari_name = "ms_pacman";
+int env_atari_replay_snapshot_interval = 500;
 bool env_conhex_use_swap_rule = true;
 float env_go_komi = 7.5;
 std::string env_go_ko_rule = "positional";
@@ -103,6 +125,11 @@ void setConfiguration(ConfigureLoader& cl)
     cl.addParameter("actor_mcts_puct_init", actor_mcts_puct_init, "hyperparameter for puct_bias in the PUCT formula of MCTS", "Actor");                                       // ref: AZ, Sec. Methods
     cl.addParameter("actor_mcts_reward_discount", actor_mcts_reward_discount, "discount factor for calculating Q values", "Actor");                                           // ref: MZ, Sec. Methods
     cl.addParameter("actor_mcts_value_rescale", actor_mcts_value_rescale, "true for games whose rewards are not bounded in [-1, 1], e.g., Atari games", "Actor");             // ref: MZ
+    cl.addParameter("actor_mcts_use_transposition", actor_mcts_use_transposition, "true for reusing the network evaluation of positions reached by transposition in the same search; only works for alphazero in games with position hash keys, e.g., go", "Actor");
+    cl.addParameter("actor_mcts_early_termination", actor_mcts_early_termination, "true for stopping the search once the most visited root child cannot be overtaken by the remaining simulations; only works with actor_select_action_by_count and without gumbel", "Actor");
+    cl.addParameter("actor_mcts_early_termination_margin", actor_mcts_early_termination_margin, "the extra simulations that the lead of the most visited root child must exceed for early termination, keeping some exploration", "Actor");
+    cl.addParameter("actor_mcts_early_termination_in_self_play", actor_mcts_early_termination_in_self_play, "true for also using early termination in self-play, only when dirichlet and gumbel noise are disabled; early termination is always used in console when enabled", "Actor");
+    cl.addParameter("actor_nn_evaluation_cache_size", actor_nn_evaluation_cache_size, "the memory size (MB) of the network evaluation cache shared by all actors in self-play, 0 for disabling the cache; only works for alphazero", "Actor");
     cl.addParameter("actor_mcts_think_batch_size", actor_mcts_think_batch_size, "the MCTS selection batch size; only works when running console", "Actor");
     cl.addParameter("actor_mcts_think_time_limit", actor_mcts_think_time_limit, "the MCTS time limit in seconds, 0 represents disabling time limit (only uses actor_num_simulation); only works when running console", "Actor");
     cl.addParameter("actor_select_action_by_count", actor_select_action_by_count, "true for selecting the action by the maximum MCTS count; should not be true together with actor_select_action_by_softmax_count", "Actor");
@@ -119,11 +146,15 @@ void setConfiguration(ConfigureLoader& cl)
     cl.addParameter("actor_gumbel_sigma_visit_c", actor_gumbel_sigma_visit_c, "hyperparameter for the monotonically increasing transformation sigma in Gumbel Zero", "Actor"); // ref: GZ, Sec. 3.4
     cl.addParameter("actor_gumbel_sigma_scale_c", actor_gumbel_sigma_scale_c, "hyperparameter for the monotonically increasing transformation sigma in Gumbel Zero", "Actor"); // ref: GZ, Sec. 3.4
     cl.addParameter("actor_resign_threshold", actor_resign_threshold, "the threshold determining when to resign in the actor", "Actor");                                       // ref: AG, Sec. Methods
+    cl.addParameter("actor_playout_cap_full_search_ratio", actor_playout_cap_full_search_ratio, "the probability of a full search with actor_num_simulation in self-play, other moves use a fast search without noise and are not trained as policy targets; 1 for disabling playout cap randomization", "Actor"); // ref: KG, Sec. 3.1
+    cl.addParameter("actor_playout_cap_fast_num_simulation", actor_playout_cap_fast_num_simulation, "the simulation number of a fast search in playout cap randomization", "Actor");
+    cl.addParameter("actor_record_binary_search_statistics", actor_record_binary_search_statistics, "true for recording the search distribution, value, and reward of each move as one compact binary (base64) field S instead of the readable text fields P, V, and R; this changes the record format, the learner of this version reads both but older tools only read the text fields", "Actor");
 
     // zero parameters
     cl.addParameter("zero_num_threads", zero_num_threads, "the number of threads that the zero server uses for zero training", "Zero");
     cl.addParameter("zero_num_parallel_games", zero_num_parallel_games, "the number of games to be run in parallel for zero training", "Zero");
     cl.addParameter("zero_server_port", zero_server_port, "the port number to host the server; workers should connect to this port number", "Zero");
+    cl.addParameter("zero_server_num_io_threads", zero_server_num_io_threads, "the number of threads that the zero server uses to communicate with workers", "Zero");
     cl.addParameter("zero_training_directory", zero_training_directory, "the output directory name for storing training results", "Zero");
     cl.addParameter("zero_num_games_per_iteration", zero_num_games_per_iteration, "the nunmber of games to play in each iteration", "Zero");
     cl.addParameter("zero_start_iteration", zero_start_iteration, "the first iteration of training; usually 1 unless continuing with previous training", "Zero");
@@ -133,6 +164,12 @@ void setConfiguration(ConfigureLoader& cl)
     cl.addParameter("zero_actor_intermediate_sequence_length", zero_actor_intermediate_sequence_length, "the max sequence length when running self-play; usually 0 (unlimited) for board games, 200 for atari games", "Zero"); // ref: MZ
     cl.addParameter("zero_actor_ignored_command", zero_actor_ignored_command, "the commands to ignore by the actor; format: command1 command2 ...", "Zero");
     cl.addParameter("zero_server_accept_different_model_games", zero_server_accept_different_model_games, "true for accepting self-play games generated by out-of-date model", "Zero");
+    cl.addParameter("zero_actor_binary_self_play_data", zero_actor_binary_self_play_data, "true for sending self-play games to the server in binary frames instead of text lines", "Zero");
+    cl.addParameter("zero_server_compress_self_play_games", zero_server_compress_self_play_games, "true for storing self-play games of each iteration as a gzip stream (sgf/[iteration].sgf.gz)", "Zero");
+    cl.addParameter("zero_server_self_play_writer_queue_size", zero_server_self_play_writer_queue_size, "the max size (in MB) of self-play games waiting to be written to disk", "Zero");
+    cl.addParameter("zero_server_self_play_data_queue_size", zero_server_self_play_data_queue_size, "the max size (in MB) of received self-play games waiting to be collected; the server stops reading from workers when exceeded", "Zero");
+    cl.addParameter("zero_server_async_training", zero_server_async_training, "true for overlapping self-play and optimization; self-play workers keep generating games with the latest model while the optimizer trains", "Zero");
+    cl.addParameter("zero_server_max_model_staleness", zero_server_max_model_staleness, "the max number of model updates that a self-play game can lag behind in asynchronous training; older games are discarded", "Zero");
     cl.addParameter("zero_display_latest_games", zero_display_latest_games, "the number of latest games to display statistics in log; 0 to disable", "Zero");
 
     // learner parameters
@@ -158,6 +195,12 @@ void setConfiguration(ConfigureLoader& cl)
     cl.addParameter("nn_num_hidden_channels", nn_num_hidden_channels, "hyperparameter for the model; the size of the hidden channels in residual blocks", "Network");               // ref: AGZ
     cl.addParameter("nn_num_value_hidden_channels", nn_num_value_hidden_channels, "hyperparameter for the model; the size of the hidden channels in the value network", "Network"); // ref: AGZ
     cl.addParameter("nn_type_name", nn_type_name, "the type of training algorithm and network: alphazero/muzero", "Network");
+    cl.addParameter("nn_cpu_num_intra_op_threads", nn_cpu_num_intra_op_threads, "the number of threads used inside one operator for cpu inference (0: libtorch default)", "Network");
+    cl.addParameter("nn_cpu_num_inter_op_threads", nn_cpu_num_inter_op_threads, "the number of threads used across operators for cpu inference (0: libtorch default)", "Network");
+    cl.addParameter("nn_cpu_optimize_for_inference", nn_cpu_optimize_for_inference, "freeze and optimize the model graph when loading it for cpu inference", "Network");
+    cl.addParameter("nn_cpu_channels_last", nn_cpu_channels_last, "use channels-last memory format for cpu inference", "Network");
+    cl.addParameter("nn_inference_service_path", nn_inference_service_path, "the unix domain socket of a local inference service shared by self-play processes (alphazero only); empty for running the network in this process", "Network");
+    cl.addParameter("nn_inference_service_max_batch_size", nn_inference_service_max_batch_size, "the max number of positions pooled into one forward by the inference service", "Network");
 
     // environment parameters
     cl.addParameter("env_board_size", env_board_size, "the size of board", "Environment");
@@ -171,6 +214,7 @@ void setConfiguration(ConfigureLoader& cl)
                                                       "#\troad_runner robotank seaquest skiing solaris space_invaders star_gunner surround tennis time_pilot\n"
                                                       "#\ttutankham up_n_down venture video_pinball wizard_of_wor yars_revenge zaxxon",
                     "Environment");
+    cl.addParameter("env_atari_replay_snapshot_interval", env_atari_replay_snapshot_interval, "the step interval to keep emulator snapshots when recovering removed observations by replaying a game; 0 to only keep the initial state", "Environment");
 #elif CONHEX
     cl.addParameter("env_conhex_use_swap_rule", env_conhex_use_swap_rule, "the swap rule in ConHex", "Environment");
 #elif GO
@@ -202,6 +246,7 @@ void setConfiguration(ConfigureLoader& cl)
     // [AG] Mastering the game of Go with deep neural networks and tree search
     // [AGZ] Mastering the game of Go without human knowledge
     // [PER] Prioritized Experience Replay
+    // [KG] Accelerating Self-Play Learning in Go
 }
 
 } // namespace minizero::config
@@ -20,6 +20,11 @@ extern int actor_mcts_think_batch_size;
 extern float actor_mcts_think_time_limit;
 extern bool actor_mcts_value_rescale;
 extern char actor_mcts_value_flipping_player;
+extern bool actor_mcts_use_transposition;
+extern bool actor_mcts_early_termination;
+extern int actor_mcts_early_termination_margin;
+extern bool actor_mcts_early_termination_in_self_play;
+extern int actor_nn_evaluation_cache_size;
 extern bool actor_select_action_by_count;
 extern bool actor_select_action_by_softmax_count;
 extern float actor_select_action_softmax_temperature;
@@ -34,11 +39,15 @@ extern int actor_gumbel_sample_size;
 extern float actor_gumbel_sigma_visit_c;
 extern float actor_gumbel_sigma_scale_c;
 extern float actor_resign_threshold;
+extern float actor_playout_cap_full_search_ratio;
+extern int actor_playout_cap_fast_num_simulation;
+extern bool actor_record_binary_search_statistics;
 
 // zero parameters
 extern int zero_num_threads;
 extern int zero_num_parallel_games;
 extern int zero_server_port;
+extern int zero_server_num_io_threads;
 extern std::string zero_training_directory;
 extern int zero_num_games_per_iteration;
 extern int zero_start_iteration;
@@ -48,6 +57,12 @@ extern float zero_disable_resign_ratio;
 extern int zero_actor_intermediate_sequence_length;
 extern std::string zero_actor_ignored_command;
 extern bool zero_server_accept_different_model_games;
+extern bool zero_actor_binary_self_play_data;
+extern bool zero_server_compress_self_play_games;
+extern int zero_server_self_play_writer_queue_size;
+extern int zero_server_self_play_data_queue_size;
+extern bool zero_server_async_training;
+extern int zero_server_max_model_staleness;
 extern int zero_display_latest_games;
 
 // learner parameters
@@ -73,6 +88,12 @@ extern int nn_num_blocks;
 extern int nn_num_hidden_channels;
 extern int nn_num_value_hidden_channels;
 extern std::string nn_type_name;
+extern int nn_cpu_num_intra_op_threads;
+extern int nn_cpu_num_inter_op_threads;
+extern bool nn_cpu_optimize_for_inference;
+extern bool nn_cpu_channels_last;
+extern std::string nn_inference_service_path;
+extern int nn_inference_service_max_batch_size;
 
 // environment parameters
 extern int env_board_size;
@@ -80,6 +101,7 @@ extern int env_board_size;
 // environment parameters for specific game
 extern std::string env_atari_rom_dir;
 extern std::string env_atari_name;
+extern int env_atari_replay_snapshot_interval;
 extern bool env_conhex_use_swap_rule;
 extern float env_go_komi;
 extern std::string env_go_ko_rule;
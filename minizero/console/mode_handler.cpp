@@ -1,14 +1,24 @@
 #include "mode_handler.h"
 #include "actor_group.h"
+#include "analysis_actor_group.h"
 #include "color_message.h"
 #include "console.h"
 #include "git_info.h"
+#include "gumbel_benchmark.h"
+#include "inference_service.h"
+#include "mcts_benchmark.h"
+#include "model_swap_test.h"
+#include "network_benchmark.h"
+#include "nn_evaluation_cache_test.h"
 #include "obs_recover.h"
 #include "obs_remover.h"
 #include "ostream_redirector.h"
 #include "random.h"
+#include "search_statistics_test.h"
 #include "zero_server.h"
+#include "zero_server_benchmark.h"
 #include <string>
+#include <torch/cuda.h>
 #include <vector>
 
 namespace minizero::console {
@@ -19,9 +29,18 @@ ModeHandler::ModeHandler()
 {
     RegisterFunction("console", this, &ModeHandler::runConsole);
     RegisterFunction("sp", this, &ModeHandler::runSelfPlay);
+    RegisterFunction("analysis", this, &ModeHandler::runAnalysis);
     RegisterFunction("zero_server", this, &ModeHandler::runZeroServer);
+    RegisterFunction("zero_server_benchmark", this, &ModeHandler::runZeroServerBenchmark);
+    RegisterFunction("network_benchmark", this, &ModeHandler::runNetworkBenchmark);
+    RegisterFunction("mcts_benchmark", this, &ModeHandler::runMCTSBenchmark);
+    RegisterFunction("gumbel_benchmark", this, &ModeHandler::runGumbelBenchmark);
+    RegisterFunction("model_swap_test", this, &ModeHandler::runModelSwapTest);
+    RegisterFunction("nn_evaluation_cache_test", this, &ModeHandler::runNNEvaluationCacheTest);
+    RegisterFunction("inference_service", this, &ModeHandler::runInferenceService);
     RegisterFunction("zero_training_name", this, &ModeHandler::runZeroTrainingName);
     RegisterFunction("env_test", this, &ModeHandler::runEnvTest);
+    RegisterFunction("search_statistics_test", this, &ModeHandler::runSearchStatisticsTest);
     RegisterFunction("remove_obs", this, &ModeHandler::runRemoveObs);
     RegisterFunction("recover_obs", this, &ModeHandler::runRecoverObs);
 }
@@ -148,12 +167,66 @@ void ModeHandler::runSelfPlay()
     ag.run();
 }
 
+void ModeHandler::runAnalysis()
+{
+    std::string position_file_name, result_file_name;
+    std::cin >> position_file_name >> result_file_name;
+
+    actor::AnalysisActorGroup ag;
+    ag.run(position_file_name, result_file_name);
+}
+
 void ModeHandler::runZeroServer()
 {
     zero::ZeroServer server;
     server.run();
 }
 
+void ModeHandler::runZeroServerBenchmark()
+{
+    zero::ZeroServerBenchmark benchmark;
+    if (!benchmark.run()) { exit(-1); }
+}
+
+void ModeHandler::runNetworkBenchmark()
+{
+    network::NetworkBenchmark benchmark(config::nn_file_name, (torch::cuda::device_count() > 0 ? 0 : -1));
+    benchmark.run();
+}
+
+void ModeHandler::runMCTSBenchmark()
+{
+    actor::MCTSBenchmark benchmark(100);
+    benchmark.run();
+}
+
+void ModeHandler::runGumbelBenchmark()
+{
+    actor::GumbelBenchmark benchmark(10, 30);
+    if (!benchmark.run()) { exit(-1); }
+}
+
+void ModeHandler::runModelSwapTest()
+{
+    std::string nn_file_name, other_nn_file_name;
+    std::cin >> nn_file_name >> other_nn_file_name;
+
+    actor::ModelSwapTest test;
+    if (!test.run(nn_file_name, other_nn_file_name)) { exit(-1); }
+}
+
+void ModeHandler::runNNEvaluationCacheTest()
+{
+    actor::NNEvaluationCacheTest test(50);
+    if (!test.run()) { exit(-1); }
+}
+
+void ModeHandler::runInferenceService()
+{
+    network::InferenceService service(config::nn_inference_service_path, config::nn_inference_service_max_batch_size, (torch::cuda::device_count() > 0 ? 0 : -1));
+    service.run();
+}
+
 void ModeHandler::runZeroTrainingName()
 {
     std::cout << Environment().name()                                                           // name for environment
@@ -191,6 +264,12 @@ void ModeHandler::runEnvTest()
     assert(env.toString() == env_str);
 }
 
+void ModeHandler::runSearchStatisticsTest()
+{
+    actor::SearchStatisticsTest test(10000);
+    if (!test.run()) { exit(-1); }
+}
+
 void ModeHandler::runRemoveObs()
 {
     std::string obs_file_path;
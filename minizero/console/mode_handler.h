@@ -44,9 +44,18 @@ protected:
     bool readConfiguration(config::ConfigureLoader& cl, const std::string& sConfigFile, const std::string& sConfigString);
     virtual void runConsole();
     virtual void runSelfPlay();
+    virtual void runAnalysis();
     virtual void runZeroServer();
+    virtual void runZeroServerBenchmark();
+    virtual void runNetworkBenchmark();
+    virtual void runMCTSBenchmark();
+    virtual void runGumbelBenchmark();
+    virtual void runModelSwapTest();
+    virtual void runNNEvaluationCacheTest();
+    virtual void runInferenceService();
     virtual void runZeroTrainingName();
     virtual void runEnvTest();
+    virtual void runSearchStatisticsTest();
     virtual void runRemoveObs();
     virtual void runRecoverObs();
 
@@ -21,6 +21,22 @@ void initialize()
     }
 }
 
+// features of a single history step: 1 plane for the action, 3 planes for the RGB observation (uint8 chw, scaled to [0, 1])
+void setAtariHistoryFeatures(float* features, int action_id, const std::string* observation)
+{
+    const int plane_size = kAtariResolution * kAtariResolution;
+    std::fill(features, features + plane_size, action_id * 1.0f / kAtariActionSize);
+    if (!observation) {
+        std::fill(features + plane_size, features + 4 * plane_size, 0.0f);
+        return;
+    }
+
+    assert(static_cast<int>(observation->size()) == 3 * plane_size);
+    const unsigned char* obs = reinterpret_cast<const unsigned char*>(observation->data());
+    float* obs_features = features + plane_size;
+    for (int i = 0; i < 3 * plane_size; ++i) { obs_features[i] = obs[i] / 255.0f; }
+}
+
 AtariAction::AtariAction(const std::vector<std::string>& action_string_args)
 {
     assert(action_string_args.size() == 2);
@@ -40,8 +56,19 @@ AtariAction::AtariAction(const std::vector<std::string>& action_string_args)
 
 AtariEnv& AtariEnv::operator=(const AtariEnv& env)
 {
-    reset(env.seed_);
-    for (const auto& action : env.getActionHistory()) { act(action); }
+    if (this == &env) { return *this; }
+
+    // restore the emulator state, including its random generator, instead of replaying all actions from the seed
+    seed_ = env.seed_;
+    if (!rom_loaded_) { loadROM(); }
+    ale_.restoreState(env.ale_.cloneState(true));
+    turn_ = env.turn_;
+    reward_ = env.reward_;
+    total_reward_ = env.total_reward_;
+    actions_ = env.actions_;
+    observations_ = env.observations_;
+    lives_history_ = env.lives_history_;
+    minimal_action_set_ = env.minimal_action_set_;
     return *this;
 }
 
@@ -51,25 +78,16 @@ void AtariEnv::reset(int seed)
     seed_ = seed;
     reward_ = 0;
     total_reward_ = 0;
-    ale_.setInt("random_seed", seed_);
-    ale_.setInt("max_num_frames_per_episode", kAtariMaxNumFramesPerEpisode);
-    ale_.setFloat("repeat_action_probability", kAtariRepeatActionProbability);
-    ale_.loadROM(config::env_atari_rom_dir + "/" + config::env_atari_name + ".bin");
-    ale_.reset_game();
-    minimal_action_set_.clear();
-    for (auto action_id : ale_.getMinimalActionSet()) { minimal_action_set_.insert(action_id); }
-    lives_history_.clear();
-    lives_history_.push_back(ale_.lives());
     actions_.clear();
     observations_.clear();
     observations_.reserve(kAtariMaxNumFramesPerEpisode + 1);
+    lives_history_.clear();
+
+    // the emulator applies the seed, which drives both the game start and the sticky actions, only when the rom is loaded,
+    // so every game loads it with its seed; copies and replays restore emulator states instead
+    loadROM();
     observations_.push_back(getObservationString()); // initial observation
-    feature_history_.clear();
-    feature_history_.resize(kAtariFeatureHistorySize, std::vector<float>(3 * kAtariResolution * kAtariResolution, 0.0f));
-    feature_history_.push_back(getObservation()); // initial screen
-    feature_history_.pop_front();
-    action_feature_history_.clear();
-    action_feature_history_.resize(kAtariFeatureHistorySize, std::vector<float>(kAtariResolution * kAtariResolution, 0.0f));
+    lives_history_.push_back(ale_.lives());
 }
 
 bool AtariEnv::act(const AtariAction& action)
@@ -84,18 +102,14 @@ bool AtariEnv::act(const AtariAction& action)
     actions_.push_back(action);
     observations_.push_back(getObservationString());
     // only keep the most recent N observations in atari games to save memory, N is determined by configuration
+    // the most recent kAtariFeatureHistorySize observations are always kept since getFeatures() reads them directly
     size_t recent_observation_length = (config::zero_actor_intermediate_sequence_length == 0 ? kAtariMaxNumFramesPerEpisode : config::zero_actor_intermediate_sequence_length + kAtariFeatureHistorySize + config::learner_n_step_return + config::learner_muzero_unrolling_step) + 1; // plus 1 for initial observation
+    assert(recent_observation_length > kAtariFeatureHistorySize);
     if (observations_.size() > recent_observation_length) {
         observations_[observations_.size() - recent_observation_length].clear();
         observations_[observations_.size() - recent_observation_length].shrink_to_fit();
     }
 
-    // action & observation history
-    action_feature_history_.push_back(std::vector<float>(kAtariResolution * kAtariResolution, action.getActionID() * 1.0f / kAtariActionSize));
-    action_feature_history_.pop_front();
-    feature_history_.push_back(getObservation());
-    feature_history_.pop_front();
-
     return true;
 }
 
@@ -111,13 +125,14 @@ std::vector<AtariAction> AtariEnv::getLegalActions() const
 
 std::vector<float> AtariEnv::getFeatures(utils::Rotation rotation /* = utils::Rotation::kRotationNone */) const
 {
-    std::vector<float> features;
-    features.reserve(kAtariFeatureHistorySize * 4 * kAtariResolution * kAtariResolution);
+    // features are built directly from the uint8 observation history, observations before the game start are zeros
+    const int history_size = 4 * kAtariResolution * kAtariResolution;
+    std::vector<float> features(kAtariFeatureHistorySize * history_size);
     for (int i = 0; i < kAtariFeatureHistorySize; ++i) { // 1 for action; 3 for RGB, action first since the latest observation didn't have action yet
-        features.insert(features.end(), action_feature_history_[i].begin(), action_feature_history_[i].end());
-        features.insert(features.end(), feature_history_[i].begin(), feature_history_[i].end());
+        int index = static_cast<int>(observations_.size()) - kAtariFeatureHistorySize + i;
+        int action_id = (index - 1 < 0 ? 0 : actions_[index - 1].getActionID());
+        setAtariHistoryFeatures(features.data() + i * history_size, action_id, (index < 0 ? nullptr : &observations_[index]));
     }
-    assert(static_cast<int>(features.size()) == kAtariFeatureHistorySize * 4 * kAtariResolution * kAtariResolution);
     return features;
 }
 
@@ -129,6 +144,34 @@ std::vector<float> AtariEnv::getActionFeatures(const AtariAction& action, utils:
     return action_features;
 }
 
+AtariEnvSnapshot AtariEnv::getSnapshot() const
+{
+    AtariEnvSnapshot snapshot;
+    snapshot.num_actions_ = actions_.size();
+    snapshot.lives_ = getLives();
+    snapshot.total_reward_ = total_reward_;
+    snapshot.observation_ = observations_.back(); // the screen is not part of the emulator state
+    snapshot.ale_state_ = ale_.cloneState(true);
+    return snapshot;
+}
+
+void AtariEnv::restoreSnapshot(int seed, const AtariEnvSnapshot& snapshot, const std::vector<AtariAction>& action_history)
+{
+    assert(static_cast<int>(action_history.size()) == snapshot.num_actions_);
+
+    // only the emulator state, the action history, and the current observation are restored
+    seed_ = seed;
+    if (!rom_loaded_) { loadROM(); }
+    ale_.restoreState(snapshot.ale_state_);
+    turn_ = Player::kPlayer1;
+    reward_ = 0;
+    total_reward_ = snapshot.total_reward_;
+    actions_ = action_history;
+    observations_.assign(action_history.size() + 1, "");
+    observations_.back() = snapshot.observation_;
+    lives_history_.assign(action_history.size() + 1, snapshot.lives_);
+}
+
 std::string AtariEnv::toString() const
 {
     // get current screen rgb
@@ -138,7 +181,19 @@ std::string AtariEnv::toString() const
     return utils::compressString(rgb_binary_string) + '\n';
 }
 
-std::vector<float> AtariEnv::getObservation(bool scale_01 /* = true */) const
+void AtariEnv::loadROM()
+{
+    ale_.setInt("random_seed", seed_);
+    ale_.setInt("max_num_frames_per_episode", kAtariMaxNumFramesPerEpisode);
+    ale_.setFloat("repeat_action_probability", kAtariRepeatActionProbability);
+    ale_.loadROM(config::env_atari_rom_dir + "/" + config::env_atari_name + ".bin");
+    ale_.reset_game();
+    minimal_action_set_.clear();
+    for (auto action_id : ale_.getMinimalActionSet()) { minimal_action_set_.insert(action_id); }
+    rom_loaded_ = true;
+}
+
+std::string AtariEnv::getObservationString() const
 {
     // get current screen rgb
     std::vector<unsigned char> screen_rgb;
@@ -150,24 +205,12 @@ std::vector<float> AtariEnv::getObservation(bool scale_01 /* = true */) const
     cv::resize(source_matrix, reshape_matrix, cv::Size(kAtariResolution, kAtariResolution), 0, 0, cv::INTER_AREA);
 
     // change hwc to chw
-    std::vector<float> observation(3 * kAtariResolution * kAtariResolution);
+    std::string obs_string(3 * kAtariResolution * kAtariResolution, '\0');
     for (int i = 0; i < 3; ++i) {
         for (int j = 0; j < kAtariResolution * kAtariResolution; ++j) {
-            observation[i * kAtariResolution * kAtariResolution + j] = static_cast<float>(reshape_matrix.at<unsigned char>(j * 3 + i));
-            if (scale_01) { observation[i * kAtariResolution * kAtariResolution + j] /= 255.0f; }
+            obs_string[i * kAtariResolution * kAtariResolution + j] = static_cast<char>(reshape_matrix.at<unsigned char>(j * 3 + i));
         }
     }
-    return observation;
-}
-
-std::string AtariEnv::getObservationString() const
-{
-    std::string obs_string;
-    std::vector<float> observation = getObservation(false);
-    for (const auto& o : observation) {
-        assert(o >= 0 && o < 256);
-        obs_string += static_cast<char>(o);
-    }
     return obs_string;
 }
 
@@ -175,6 +218,7 @@ void AtariEnvLoader::reset()
 {
     BaseEnvLoader::reset();
     observations_.clear();
+    replay_snapshots_ = std::make_shared<ReplaySnapshots>();
 }
 
 bool AtariEnvLoader::loadFromString(const std::string& content)
@@ -198,25 +242,20 @@ void AtariEnvLoader::loadFromEnvironment(const AtariEnv& env, const std::vector<
 
 std::vector<float> AtariEnvLoader::getFeatures(const int pos, utils::Rotation rotation /* = utils::Rotation::kRotationNone */) const
 {
-    std::vector<float> features;
-    features.reserve(kAtariFeatureHistorySize * 4 * kAtariResolution * kAtariResolution);
+    const int history_size = 4 * kAtariResolution * kAtariResolution;
+    std::vector<float> features(kAtariFeatureHistorySize * history_size);
     int start = pos - kAtariFeatureHistorySize + 1, end = pos;
     for (int i = start; i <= end; ++i) { // 1 for action; 3 for RGB, action first since the latest observation didn't have action yet
         int action_id = (i - 1 < 0 ? 0
                                    : (i - 1 >= static_cast<int>(action_pairs_.size()) ? utils::Random::randInt() % kAtariActionSize : action_pairs_[i - 1].first.getActionID()));
         assert(action_id >= 0 && action_id < kAtariActionSize);
-        std::vector<float> action_features(kAtariResolution * kAtariResolution, action_id * 1.0f / kAtariActionSize);
-        features.insert(features.end(), action_features.begin(), action_features.end());
+        const std::string* observation = nullptr;
         if (i >= 0) {
-            const std::string& observation = (i < static_cast<int>(observations_.size()) ? observations_[i] : observations_.back());
-            if (observation.empty()) { return getFeaturesByReplay(pos, rotation); }
-            for (const auto& o : observation) { features.push_back(static_cast<unsigned int>(static_cast<unsigned char>(o)) / 255.0f); }
-        } else {
-            std::vector<float> f(3 * kAtariResolution * kAtariResolution, 0.0f);
-            features.insert(features.end(), f.begin(), f.end());
+            observation = (i < static_cast<int>(observations_.size()) ? &observations_[i] : &observations_.back());
+            if (observation->empty()) { return getFeaturesByReplay(pos, rotation); }
         }
+        setAtariHistoryFeatures(features.data() + (i - start) * history_size, action_id, observation);
     }
-    assert(static_cast<int>(features.size()) == kAtariFeatureHistorySize * 4 * kAtariResolution * kAtariResolution);
     return features;
 }
 
@@ -250,9 +289,44 @@ void AtariEnvLoader::addObservations(const std::string& compressed_obs)
 
 std::vector<float> AtariEnvLoader::getFeaturesByReplay(const int pos, utils::Rotation rotation /* = utils::Rotation::kRotationNone */) const
 {
-    AtariEnv env;
-    env.reset(std::stoi(getTag("SD")));
-    for (int i = 0; i < pos; ++i) { env.act(action_pairs_[i].first); }
+    // each thread keeps its own environment, which restores snapshots without loading the rom again
+    thread_local AtariEnv env;
+    const int seed = std::stoi(getTag("SD"));
+    const int interval = config::env_atari_replay_snapshot_interval;
+    const int start = std::max(0, pos - kAtariFeatureHistorySize + 1); // the earliest observation used by the features
+
+    // resume from the latest snapshot taken before the earliest observation, or from the seed if there is none,
+    // snapshots are stored without observations since all required observations are regenerated by replaying
+    std::shared_ptr<ReplaySnapshots> replay_snapshots = (replay_snapshots_ ? replay_snapshots_ : std::make_shared<ReplaySnapshots>());
+    {
+        std::lock_guard<std::mutex> lock(replay_snapshots->mutex_);
+        auto it = replay_snapshots->snapshots_.upper_bound(start - 1);
+        if (it != replay_snapshots->snapshots_.begin()) {
+            --it;
+            std::vector<AtariAction> action_history;
+            action_history.reserve(it->first);
+            for (int i = 0; i < it->first; ++i) { action_history.push_back(action_pairs_[i].first); }
+            env.restoreSnapshot(seed, it->second, action_history);
+        } else {
+            env.reset(seed);
+            AtariEnvSnapshot snapshot = env.getSnapshot();
+            snapshot.observation_.clear();
+            replay_snapshots->snapshots_.emplace(0, std::move(snapshot));
+        }
+    }
+
+    std::vector<AtariEnvSnapshot> new_snapshots;
+    for (int i = env.getActionHistory().size(); i < pos; ++i) {
+        env.act(action_pairs_[i].first);
+        if (interval > 0 && (i + 1) % interval == 0) {
+            new_snapshots.push_back(env.getSnapshot());
+            new_snapshots.back().observation_.clear();
+        }
+    }
+    if (!new_snapshots.empty()) {
+        std::lock_guard<std::mutex> lock(replay_snapshots->mutex_);
+        for (auto& snapshot : new_snapshots) { replay_snapshots->snapshots_.emplace(snapshot.num_actions_, std::move(snapshot)); }
+    }
     return env.getFeatures(rotation);
 }
 
@@ -5,7 +5,9 @@
 #include "random.h"
 #include <ale_interface.hpp>
 #include <algorithm>
-#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -41,14 +43,24 @@ public:
     inline std::string toConsoleString() const override { return getAtariActionName(action_id_); }
 };
 
+// emulator state of a game at a specific step, which can be restored without replaying the game from its seed
+class AtariEnvSnapshot {
+public:
+    int num_actions_;
+    int lives_;
+    float total_reward_;
+    std::string observation_;
+    ale::ALEState ale_state_; // including the random generator of sticky actions
+};
+
 class AtariEnv : public BaseEnv<AtariAction> {
 public:
-    AtariEnv()
+    AtariEnv() : rom_loaded_(false)
     {
         ale::Logger::setMode(ale::Logger::mode::Error);
         reset();
     }
-    AtariEnv(const AtariEnv& env) { *this = env; }
+    AtariEnv(const AtariEnv& env) : seed_(env.seed_), rom_loaded_(false) { *this = env; }
     AtariEnv& operator=(const AtariEnv& env);
 
     void reset() override { reset(utils::Random::randInt()); }
@@ -82,6 +94,8 @@ public:
     inline int getFrameNumber() const { return ale_.getFrameNumber(); }
     inline int getEpisodeFrameNumber() const { return ale_.getEpisodeFrameNumber(); }
     inline const std::vector<int> getLivesHistory() const { return lives_history_; }
+    AtariEnvSnapshot getSnapshot() const;
+    void restoreSnapshot(int seed, const AtariEnvSnapshot& snapshot, const std::vector<AtariAction>& action_history);
 
     static void setUpEnv()
     {
@@ -92,17 +106,16 @@ public:
     }
 
 private:
-    std::vector<float> getObservation(bool scale_01 = true) const;
+    void loadROM();
     std::string getObservationString() const;
 
     int seed_;
     float reward_;
     float total_reward_;
-    ale::ALEInterface ale_;
+    bool rom_loaded_;
+    mutable ale::ALEInterface ale_; // cloning the emulator state does not change the game
     std::vector<int> lives_history_;
     std::unordered_set<int> minimal_action_set_;
-    std::deque<std::vector<float>> feature_history_;
-    std::deque<std::vector<float>> action_feature_history_;
 };
 
 class AtariEnvLoader : public BaseEnvLoader<AtariAction, AtariEnv> {
@@ -122,12 +135,19 @@ public:
     inline int getRotateAction(int action_id, utils::Rotation rotation) const override { return action_id; }
 
 private:
+    class ReplaySnapshots {
+    public:
+        std::mutex mutex_;
+        std::map<int, AtariEnvSnapshot> snapshots_; // number of actions -> snapshot
+    };
+
     void addObservations(const std::string& compressed_obs);
     std::vector<float> getFeaturesByReplay(const int pos, utils::Rotation rotation = utils::Rotation::kRotationNone) const;
     float calculateNStepValue(const int pos) const;
     std::vector<float> toDiscreteValue(float value) const;
 
     std::vector<std::string> observations_;
+    std::shared_ptr<ReplaySnapshots> replay_snapshots_;
 };
 
 } // namespace minizero::env::atari
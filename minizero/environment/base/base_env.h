@@ -2,11 +2,14 @@
 
 #include "configuration.h"
 #include "rotation.h"
+#include "search_statistics.h"
 #include "sgf_loader.h"
 #include "utils.h"
 #include "vector_map.h"
 #include <algorithm>
+#include <array>
 #include <cassert>
+#include <cstdint>
 #include <fstream>
 #include <memory>
 #include <sstream>
@@ -70,6 +73,28 @@ private:
     T white_;
 };
 
+// fixed-capacity neighbor list, used by the static board topology tables shared by all environments
+template <int kCapacity>
+class NeighborList {
+public:
+    NeighborList() : size_(0) {}
+
+    inline void add(int position)
+    {
+        assert(size_ < kCapacity && position >= 0 && position <= INT16_MAX);
+        positions_[size_++] = static_cast<int16_t>(position);
+    }
+    inline bool contains(int position) const { return std::find(begin(), end(), position) != end(); }
+    inline int size() const { return size_; }
+    inline int operator[](int index) const { return positions_[index]; }
+    inline const int16_t* begin() const { return positions_.data(); }
+    inline const int16_t* end() const { return positions_.data() + size_; }
+
+private:
+    std::array<int16_t, kCapacity> positions_;
+    int16_t size_;
+};
+
 template <class Action>
 class BaseEnv {
 public:
@@ -243,7 +268,15 @@ public:
     virtual std::vector<float> getPolicy(const int pos, utils::Rotation rotation = utils::Rotation::kRotationNone) const
     {
         std::vector<float> policy(getPolicySize(), 0.0f);
-        if (pos < static_cast<int>(action_pairs_.size())) {
+        utils::SearchStatistics search_statistics;
+        if (getSearchStatistics(pos, search_statistics)) {
+            float total = 0.0f;
+            for (const auto& p : search_statistics.distribution_) {
+                policy[getRotateAction(p.first, rotation)] = p.second;
+                total += p.second;
+            }
+            for (auto& p : policy) { p /= total; }
+        } else if (pos < static_cast<int>(action_pairs_.size())) {
             const std::string policy_distribution = action_pairs_[pos].second["P"];
             if (policy_distribution.empty()) {
                 policy[getRotateAction(action_pairs_[pos].first.getActionID(), rotation)] = 1.0f;
@@ -275,15 +308,41 @@ public:
         }
     }
 
-    virtual std::vector<float> getValue(const int pos) const { return (pos < static_cast<int>(action_pairs_.size()) ? std::vector<float>{std::stof(action_pairs_[pos].second["V"])} : std::vector<float>{0.0f}); }
-    virtual std::vector<float> getReward(const int pos) const { return (pos < static_cast<int>(action_pairs_.size()) ? std::vector<float>{std::stof(action_pairs_[pos].second["R"])} : std::vector<float>{0.0f}); }
+    virtual std::vector<float> getValue(const int pos) const
+    {
+        utils::SearchStatistics search_statistics;
+        if (getSearchStatistics(pos, search_statistics)) { return {search_statistics.value_}; }
+        return (pos < static_cast<int>(action_pairs_.size()) ? std::vector<float>{std::stof(action_pairs_[pos].second["V"])} : std::vector<float>{0.0f});
+    }
+    virtual std::vector<float> getReward(const int pos) const
+    {
+        utils::SearchStatistics search_statistics;
+        if (getSearchStatistics(pos, search_statistics)) { return {search_statistics.reward_}; }
+        return (pos < static_cast<int>(action_pairs_.size()) ? std::vector<float>{std::stof(action_pairs_[pos].second["R"])} : std::vector<float>{0.0f});
+    }
     virtual bool setActionPairInfo(const int pos, const std::string& tag, const std::string value)
     {
         if (pos >= static_cast<int>(action_pairs_.size())) { return false; }
         action_pairs_[pos].second[tag] = value;
         return true;
     }
+    virtual bool setValue(const int pos, const float value)
+    {
+        // the value is updated in the field it is recorded in, i.e., the binary search statistics or the text value
+        utils::SearchStatistics search_statistics;
+        if (!getSearchStatistics(pos, search_statistics)) { return setActionPairInfo(pos, "V", std::to_string(value)); }
+        search_statistics.value_ = value;
+        return setActionPairInfo(pos, "S", search_statistics.encode());
+    }
+    virtual bool getSearchStatistics(const int pos, utils::SearchStatistics& search_statistics) const
+    {
+        // only records with actor_record_binary_search_statistics contain the binary search statistics
+        if (pos >= static_cast<int>(action_pairs_.size())) { return false; }
+        const std::string& encoded = action_pairs_[pos].second["S"];
+        return !encoded.empty() && search_statistics.decode(encoded);
+    }
     virtual float getPriority(const int pos) const { return 1.0f; }
+    virtual bool isFullSearch(const int pos) const { return (pos >= static_cast<int>(action_pairs_.size()) || action_pairs_[pos].second["PC"] != "0"); }
 
     virtual std::vector<float> getActionFeatures(const int pos, utils::Rotation rotation = utils::Rotation::kRotationNone) const = 0;
     virtual std::string name() const = 0;
@@ -4,72 +4,88 @@
 #include "sgf_loader.h"
 #include <algorithm>
 #include <iostream>
+#include <set>
 #include <string>
 
 namespace minizero::env::conhex {
 
 using namespace minizero::utils;
 
-void ConHexGraph::initGraph()
+const ConHexGraph::ConHexGraphTopology& ConHexGraph::getTopology()
 {
-    addCell({0, 1, 9}, ConHexGraphEdgeFlag::TOP | ConHexGraphEdgeFlag::LEFT);
-    addCell({1, 2, 3}, ConHexGraphEdgeFlag::TOP);
-    addCell({3, 4, 5}, ConHexGraphEdgeFlag::TOP);
-    addCell({5, 6, 7}, ConHexGraphEdgeFlag::TOP);
-    addCell({7, 8, 17}, ConHexGraphEdgeFlag::TOP | ConHexGraphEdgeFlag::RIGHT);
-    addCell({17, 26, 35}, ConHexGraphEdgeFlag::RIGHT);
-    addCell({35, 44, 53}, ConHexGraphEdgeFlag::RIGHT);
-    addCell({53, 62, 71}, ConHexGraphEdgeFlag::RIGHT);
-    addCell({71, 79, 80}, ConHexGraphEdgeFlag::RIGHT | ConHexGraphEdgeFlag::BOTTOM);
-    addCell({77, 78, 79}, ConHexGraphEdgeFlag::BOTTOM);
-    addCell({75, 76, 77}, ConHexGraphEdgeFlag::BOTTOM);
-    addCell({73, 74, 75}, ConHexGraphEdgeFlag::BOTTOM);
-    addCell({63, 72, 73}, ConHexGraphEdgeFlag::BOTTOM | ConHexGraphEdgeFlag::LEFT);
-    addCell({45, 54, 63}, ConHexGraphEdgeFlag::LEFT);
-    addCell({27, 36, 45}, ConHexGraphEdgeFlag::LEFT);
-    addCell({9, 18, 27}, ConHexGraphEdgeFlag::LEFT);
-    addCell({1, 2, 9, 11, 18, 19}, ConHexGraphEdgeFlag::NONE);
-    addCell({2, 3, 4, 11, 12, 13}, ConHexGraphEdgeFlag::NONE);
-    addCell({4, 5, 6, 13, 14, 15}, ConHexGraphEdgeFlag::NONE);
-    addCell({6, 7, 15, 17, 25, 26}, ConHexGraphEdgeFlag::NONE);
-    addCell({25, 26, 34, 35, 43, 44}, ConHexGraphEdgeFlag::NONE);
-    addCell({43, 44, 52, 53, 61, 62}, ConHexGraphEdgeFlag::NONE);
-    addCell({61, 62, 69, 71, 78, 79}, ConHexGraphEdgeFlag::NONE);
-    addCell({67, 68, 69, 76, 77, 78}, ConHexGraphEdgeFlag::NONE);
-    addCell({65, 66, 67, 74, 75, 76}, ConHexGraphEdgeFlag::NONE);
-    addCell({54, 55, 63, 65, 73, 74}, ConHexGraphEdgeFlag::NONE);
-    addCell({36, 37, 45, 46, 54, 55}, ConHexGraphEdgeFlag::NONE);
-    addCell({18, 19, 27, 28, 36, 37}, ConHexGraphEdgeFlag::NONE);
-    addCell({11, 12, 19, 21, 28, 29}, ConHexGraphEdgeFlag::NONE);
-    addCell({12, 13, 14, 21, 22, 23}, ConHexGraphEdgeFlag::NONE);
-    addCell({14, 15, 23, 25, 33, 34}, ConHexGraphEdgeFlag::NONE);
-    addCell({33, 34, 42, 43, 51, 52}, ConHexGraphEdgeFlag::NONE);
-    addCell({51, 52, 59, 61, 68, 69}, ConHexGraphEdgeFlag::NONE);
-    addCell({57, 58, 59, 66, 67, 68}, ConHexGraphEdgeFlag::NONE);
-    addCell({46, 47, 55, 57, 65, 66}, ConHexGraphEdgeFlag::NONE);
-    addCell({28, 29, 37, 38, 46, 47}, ConHexGraphEdgeFlag::NONE);
-    addCell({21, 22, 29, 31, 38, 39}, ConHexGraphEdgeFlag::NONE);
-    addCell({22, 23, 31, 33, 41, 42}, ConHexGraphEdgeFlag::NONE);
-    addCell({41, 42, 49, 51, 58, 59}, ConHexGraphEdgeFlag::NONE);
-    addCell({38, 39, 47, 49, 57, 58}, ConHexGraphEdgeFlag::NONE);
-    addCell({31, 39, 40, 41, 49}, ConHexGraphEdgeFlag::NONE);
+    static const ConHexGraphTopology topology = []() {
+        ConHexGraphTopology topology;
+        initGraph(topology);
+        return topology;
+    }();
+    return topology;
+}
+
+void ConHexGraph::initGraph(ConHexGraphTopology& topology)
+{
+    addCell(topology, {0, 1, 9}, ConHexGraphEdgeFlag::TOP | ConHexGraphEdgeFlag::LEFT);
+    addCell(topology, {1, 2, 3}, ConHexGraphEdgeFlag::TOP);
+    addCell(topology, {3, 4, 5}, ConHexGraphEdgeFlag::TOP);
+    addCell(topology, {5, 6, 7}, ConHexGraphEdgeFlag::TOP);
+    addCell(topology, {7, 8, 17}, ConHexGraphEdgeFlag::TOP | ConHexGraphEdgeFlag::RIGHT);
+    addCell(topology, {17, 26, 35}, ConHexGraphEdgeFlag::RIGHT);
+    addCell(topology, {35, 44, 53}, ConHexGraphEdgeFlag::RIGHT);
+    addCell(topology, {53, 62, 71}, ConHexGraphEdgeFlag::RIGHT);
+    addCell(topology, {71, 79, 80}, ConHexGraphEdgeFlag::RIGHT | ConHexGraphEdgeFlag::BOTTOM);
+    addCell(topology, {77, 78, 79}, ConHexGraphEdgeFlag::BOTTOM);
+    addCell(topology, {75, 76, 77}, ConHexGraphEdgeFlag::BOTTOM);
+    addCell(topology, {73, 74, 75}, ConHexGraphEdgeFlag::BOTTOM);
+    addCell(topology, {63, 72, 73}, ConHexGraphEdgeFlag::BOTTOM | ConHexGraphEdgeFlag::LEFT);
+    addCell(topology, {45, 54, 63}, ConHexGraphEdgeFlag::LEFT);
+    addCell(topology, {27, 36, 45}, ConHexGraphEdgeFlag::LEFT);
+    addCell(topology, {9, 18, 27}, ConHexGraphEdgeFlag::LEFT);
+    addCell(topology, {1, 2, 9, 11, 18, 19}, ConHexGraphEdgeFlag::NONE);
+    addCell(topology, {2, 3, 4, 11, 12, 13}, ConHexGraphEdgeFlag::NONE);
+    addCell(topology, {4, 5, 6, 13, 14, 15}, ConHexGraphEdgeFlag::NONE);
+    addCell(topology, {6, 7, 15, 17, 25, 26}, ConHexGraphEdgeFlag::NONE);
+    addCell(topology, {25, 26, 34, 35, 43, 44}, ConHexGraphEdgeFlag::NONE);
+    addCell(topology, {43, 44, 52, 53, 61, 62}, ConHexGraphEdgeFlag::NONE);
+    addCell(topology, {61, 62, 69, 71, 78, 79}, ConHexGraphEdgeFlag::NONE);
+    addCell(topology, {67, 68, 69, 76, 77, 78}, ConHexGraphEdgeFlag::NONE);
+    addCell(topology, {65, 66, 67, 74, 75, 76}, ConHexGraphEdgeFlag::NONE);
+    addCell(topology, {54, 55, 63, 65, 73, 74}, ConHexGraphEdgeFlag::NONE);
+    addCell(topology, {36, 37, 45, 46, 54, 55}, ConHexGraphEdgeFlag::NONE);
+    addCell(topology, {18, 19, 27, 28, 36, 37}, ConHexGraphEdgeFlag::NONE);
+    addCell(topology, {11, 12, 19, 21, 28, 29}, ConHexGraphEdgeFlag::NONE);
+    addCell(topology, {12, 13, 14, 21, 22, 23}, ConHexGraphEdgeFlag::NONE);
+    addCell(topology, {14, 15, 23, 25, 33, 34}, ConHexGraphEdgeFlag::NONE);
+    addCell(topology, {33, 34, 42, 43, 51, 52}, ConHexGraphEdgeFlag::NONE);
+    addCell(topology, {51, 52, 59, 61, 68, 69}, ConHexGraphEdgeFlag::NONE);
+    addCell(topology, {57, 58, 59, 66, 67, 68}, ConHexGraphEdgeFlag::NONE);
+    addCell(topology, {46, 47, 55, 57, 65, 66}, ConHexGraphEdgeFlag::NONE);
+    addCell(topology, {28, 29, 37, 38, 46, 47}, ConHexGraphEdgeFlag::NONE);
+    addCell(topology, {21, 22, 29, 31, 38, 39}, ConHexGraphEdgeFlag::NONE);
+    addCell(topology, {22, 23, 31, 33, 41, 42}, ConHexGraphEdgeFlag::NONE);
+    addCell(topology, {41, 42, 49, 51, 58, 59}, ConHexGraphEdgeFlag::NONE);
+    addCell(topology, {38, 39, 47, 49, 57, 58}, ConHexGraphEdgeFlag::NONE);
+    addCell(topology, {31, 39, 40, 41, 49}, ConHexGraphEdgeFlag::NONE);
 
+    std::vector<std::set<int>> cell_adjacency_list(kConHexBoardSize * kConHexBoardSize);
     for (int hole_idx = 0; hole_idx < kConHexBoardSize * kConHexBoardSize; ++hole_idx) {
-        if (hole_to_cell_map_[hole_idx].size() == 1) { continue; }
-        if (hole_to_cell_map_[hole_idx].size() == 2) { continue; }
-        if (hole_to_cell_map_[hole_idx].size() == 3) {
-            std::array<int, 3> combination = {hole_to_cell_map_[hole_idx][0], hole_to_cell_map_[hole_idx][1], hole_to_cell_map_[hole_idx][2]};
+        const ConHexHoleCellList& hole_cells = topology.hole_to_cell_map_[hole_idx];
+        if (hole_cells.size() == 1) { continue; }
+        if (hole_cells.size() == 2) { continue; }
+        if (hole_cells.size() == 3) {
+            std::array<int, 3> combination = {hole_cells[0], hole_cells[1], hole_cells[2]};
             for (int i = 0; i < static_cast<int>(combination.size()); ++i) {
                 for (int j = 0; j < static_cast<int>(combination.size()); ++j) {
                     if (i == j) { continue; }
-                    cell_adjacency_list_[combination[i]].insert(combination[j]);
+                    cell_adjacency_list[combination[i]].insert(combination[j]);
                 }
             }
         }
     }
+    for (int cell_id = 0; cell_id < static_cast<int>(cell_adjacency_list.size()); ++cell_id) {
+        for (int near_cell_id : cell_adjacency_list[cell_id]) { topology.cell_adjacency_list_[cell_id].add(near_cell_id); }
+    }
 }
 
-void ConHexGraph::addCell(std::vector<int> hole_indexes, ConHexGraphEdgeFlag cell_edge_flag)
+void ConHexGraph::addCell(ConHexGraphTopology& topology, std::vector<int> hole_indexes, ConHexGraphEdgeFlag cell_edge_flag)
 {
     ConHexGraphCellType cell_type = ConHexGraphCellType::NONE;
     if (hole_indexes.size() == ConHexGraphCellType::INNER) { cell_type = ConHexGraphCellType::INNER; }
@@ -78,22 +94,20 @@ void ConHexGraph::addCell(std::vector<int> hole_indexes, ConHexGraphEdgeFlag cel
 
     assert(cell_type == ConHexGraphCellType::NONE);
 
-    int cell_id = cells_.size();
-    cells_.emplace_back(ConHexGraphCell(cell_id, cell_type));
-    cells_.back().setEdgeFlag(cell_edge_flag);
+    int cell_id = topology.cells_.size();
+    topology.cells_.emplace_back(ConHexGraphCell(cell_id, cell_type));
+    topology.cells_.back().setEdgeFlag(cell_edge_flag);
 
     // add
     for (auto& hole_index : hole_indexes) {
-        hole_to_cell_map_[hole_index].push_back(cell_id);
+        topology.hole_to_cell_map_[hole_index].add(cell_id);
     }
 }
 
 ConHexGraph::ConHexGraph() : graph_dsu_(kConHexBoardSize * kConHexBoardSize)
 {
-    cell_adjacency_list_ = std::vector<std::set<int>>(kConHexBoardSize * kConHexBoardSize, std::set<int>());
-    hole_to_cell_map_ = std::vector<std::vector<int>>(kConHexBoardSize * kConHexBoardSize, std::vector<int>());
-    cells_ = std::vector<ConHexGraphCell>();
-    initGraph();
+    topology_ = &getTopology();
+    cells_ = topology_->cells_;
     reset();
 }
 
@@ -231,7 +245,7 @@ void ConHexGraph::placeStone(int hole_idx, Player player)
     assert(holes_[hole_idx] != Player::kPlayerNone);
     holes_[hole_idx] = player;
 
-    for (int& cell_id : hole_to_cell_map_[hole_idx]) {
+    for (int cell_id : topology_->hole_to_cell_map_[hole_idx]) {
         ConHexGraphCell& cell = cells_[cell_id];
         // may have many cell on same hole, at most 3 layers (cells)
         cell.placeStone(hole_idx, player);
@@ -252,7 +266,7 @@ void ConHexGraph::placeStone(int hole_idx, Player player)
             graph_dsu_.connect(cell_id, bottom_id_);
         }
 
-        for (int near_cell_id : cell_adjacency_list_[cell_id]) {
+        for (int near_cell_id : topology_->cell_adjacency_list_[cell_id]) {
             if (cells_[near_cell_id].getCapturedPlayer() == cell_captured_player) {
                 graph_dsu_.connect(near_cell_id, cell_id);
             }
@@ -4,13 +4,16 @@
 #include "conhex_graph_cell.h"
 #include "conhex_graph_flag.h"
 #include "disjoint_set_union.h"
-#include <set>
+#include <array>
 #include <string>
 #include <utility>
 #include <vector>
 
 namespace minizero::env::conhex {
 
+typedef NeighborList<3> ConHexHoleCellList;
+typedef NeighborList<6> ConHexCellNeighborList;
+
 class ConHexGraph {
 public:
     ConHexGraph();
@@ -23,12 +26,20 @@ public:
     std::string toString() const;
 
 private:
-    void initGraph();
-    void addCell(std::vector<int> hole_indexes, ConHexGraphEdgeFlag cell_edge_flag);
+    // the board topology is fixed, so it is built once and shared by all graphs
+    class ConHexGraphTopology {
+    public:
+        std::vector<ConHexGraphCell> cells_;                                                         // initial cells
+        std::array<ConHexHoleCellList, kConHexBoardSize * kConHexBoardSize> hole_to_cell_map_;       // hole_idx* -> cell_id, on same hole id may have many cell
+        std::array<ConHexCellNeighborList, kConHexBoardSize * kConHexBoardSize> cell_adjacency_list_; // cell_id -> cell_id* , adj list
+    };
+
+    static const ConHexGraphTopology& getTopology();
+    static void initGraph(ConHexGraphTopology& topology);
+    static void addCell(ConHexGraphTopology& topology, std::vector<int> hole_indexes, ConHexGraphEdgeFlag cell_edge_flag);
 
     DisjointSetUnion graph_dsu_;
-    std::vector<std::vector<int>> hole_to_cell_map_; // hole_idx* -> cell_id, on same hole id may have many cell
-    std::vector<std::set<int>> cell_adjacency_list_; // cell_id -> cell_id* , adj list
+    const ConHexGraphTopology* topology_;
 
     std::vector<ConHexGraphCell> cells_;
     std::vector<Player> holes_;
@@ -2,6 +2,8 @@
 #include "color_message.h"
 #include "random.h"
 #include "sgf_loader.h"
+#include <array>
+#include <mutex>
 #include <random>
 #include <sstream>
 #include <string>
@@ -15,6 +17,8 @@ GoHashKey turn_hash_key;
 std::vector<GoHashKey> empty_hash_key;
 std::vector<GamePair<GoHashKey>> grids_hash_key;
 std::vector<std::vector<GamePair<GoHashKey>>> sequence_hash_key;
+std::array<std::array<GoNeighborList, kMaxGoBoardSize * kMaxGoBoardSize>, kMaxGoBoardSize + 1> neighbor_tables;
+std::array<std::once_flag, kMaxGoBoardSize + 1> neighbor_table_flags;
 
 void initialize()
 {
@@ -69,6 +73,27 @@ GoHashKey getGoSequenceHashKey(int move, int position, Player p)
     return sequence_hash_key[move][position].get(p);
 }
 
+const GoNeighborList& getGoNeighbors(int position, int board_size)
+{
+    assert(board_size > 0 && board_size <= kMaxGoBoardSize);
+    assert(position >= 0 && position < board_size * board_size);
+
+    // neighbor tables are built once per board size and shared by all grids of all environments
+    std::call_once(neighbor_table_flags[board_size], [board_size]() {
+        const std::array<int, 4> directions = {0, 1, 0, -1};
+        for (int pos = 0; pos < board_size * board_size; ++pos) {
+            int x = pos % board_size, y = pos / board_size;
+            for (size_t i = 0; i < directions.size(); ++i) {
+                int new_x = x + directions[i];
+                int new_y = y + directions[(i + 1) % directions.size()];
+                if (new_x < 0 || new_x >= board_size || new_y < 0 || new_y >= board_size) { continue; }
+                neighbor_tables[board_size][pos].add(new_y * board_size + new_x);
+            }
+        }
+    });
+    return neighbor_tables[board_size][position];
+}
+
 GoEnv& GoEnv::operator=(const GoEnv& env)
 {
     board_size_ = env.board_size_;
@@ -573,7 +598,7 @@ GoArea* GoEnv::mergeArea(GoArea* area1, GoArea* area2)
 std::vector<GoBitboard> GoEnv::findAreas(const GoAction& action)
 {
     const GoGrid& grid = grids_[action.getActionID()];
-    const std::vector<int>& neighbors = grid.getNeighbors();
+    const GoNeighborList& neighbors = grid.getNeighbors();
     std::vector<GoBitboard> areas;
     GoBitboard checked_area;
     GoBitboard boundary_bitboard = ~stone_bitboard_.get(action.getPlayer()) & board_mask_bitboard_;
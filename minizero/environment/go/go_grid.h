@@ -3,10 +3,13 @@
 #include "go_area.h"
 #include "go_block.h"
 #include "go_unit.h"
-#include <vector>
 
 namespace minizero::env::go {
 
+typedef NeighborList<4> GoNeighborList;
+
+const GoNeighborList& getGoNeighbors(int position, int board_size);
+
 class GoGrid {
 public:
     GoGrid(int position, int board_size)
@@ -20,7 +23,7 @@ public:
         player_ = Player::kPlayerNone;
         block_ = nullptr;
         area_pair_ = GamePair<GoArea*>(nullptr, nullptr);
-        initializeNeighbors(board_size);
+        neighbors_ = &getGoNeighbors(position_, board_size);
     }
 
     // setter
@@ -37,32 +40,14 @@ public:
     inline const GamePair<GoArea*>& getAreaPair() const { return area_pair_; }
     inline GoBlock* getBlock() { return block_; }
     inline const GoBlock* getBlock() const { return block_; }
-    inline const std::vector<int>& getNeighbors() const { return neighbors_; }
+    inline const GoNeighborList& getNeighbors() const { return *neighbors_; }
 
 private:
-    void initializeNeighbors(int board_size)
-    {
-        const std::vector<int> directions = {0, 1, 0, -1};
-        int x = position_ % board_size, y = position_ / board_size;
-        neighbors_.clear();
-        for (size_t i = 0; i < directions.size(); ++i) {
-            int new_x = x + directions[i];
-            int new_y = y + directions[(i + 1) % directions.size()];
-            if (!isInBoard(new_x, new_y, board_size)) { continue; }
-            neighbors_.push_back(new_y * board_size + new_x);
-        }
-    }
-
-    inline bool isInBoard(int x, int y, int board_size)
-    {
-        return (x >= 0 && x < board_size && y >= 0 && y < board_size);
-    }
-
     int position_;
     Player player_;
     GoBlock* block_;
     GamePair<GoArea*> area_pair_;
-    std::vector<int> neighbors_;
+    const GoNeighborList* neighbors_;
 };
 
 } // namespace minizero::env::go
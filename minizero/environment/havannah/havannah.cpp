@@ -4,6 +4,7 @@
 #include "sgf_loader.h"
 #include <algorithm>
 #include <iostream>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -12,6 +13,9 @@ namespace minizero::env::havannah {
 
 using namespace minizero::utils;
 
+std::array<HavannahNeighborTable, kMaxHavannahBoardSize + 1> neighbor_tables;
+std::array<std::once_flag, kMaxHavannahBoardSize + 1> neighbor_table_flags;
+
 HavannahEnv& HavannahEnv::operator=(const HavannahEnv& env)
 {
     turn_ = env.turn_;
@@ -53,13 +57,14 @@ void HavannahEnv::initialize()
     */
     cells_.clear();
     paths_.clear();
-    neighbors_.clear();
     for (int pos = 0; pos < extended_board_size_ * extended_board_size_; ++pos) {
         cells_.emplace_back(HavannahCell(pos, extended_board_size_));
         paths_.emplace_back(HavannahPath(pos));
-        neighbors_.emplace_back(std::array<int, 7>());
     }
-    calculateNeighbors();
+
+    // neighbor tables are built once per board size and shared by all environments
+    std::call_once(neighbor_table_flags[board_size_], [this]() { calculateNeighbors(neighbor_tables[board_size_]); });
+    neighbors_ = neighbor_tables[board_size_].data();
 
     // initialize border bitboards (6 sides)
     border_bitboards_.resize(6);
@@ -131,8 +136,6 @@ bool HavannahEnv::act(const HavannahAction& action)
     new_path->setPlayer(player);
     new_path->addCell(action_id);
     for (int neighbor : neighbors_[action_id]) {
-        if (neighbor == -1) { break; }
-
         HavannahCell* neighbor_cell = &cells_[neighbor];
         if (neighbor_cell->getPlayer() != player) { continue; }
 
@@ -290,24 +293,19 @@ Player HavannahEnv::updateWinner(const HavannahAction& action)
     return Player::kPlayerNone;
 }
 
-void HavannahEnv::calculateNeighbors()
+void HavannahEnv::calculateNeighbors(HavannahNeighborTable& neighbors) const
 {
     for (int i = 0; i < extended_board_size_; ++i) {
         for (int j = 0; j < extended_board_size_; ++j) {
             if (!isValidCoor(i, j)) { continue; }
 
             int index = i * extended_board_size_ + j;
-            int k = 0;
             std::array<std::pair<int, int>, 6> nbrs = {{std::make_pair(i - 1, j), std::make_pair(i - 1, j + 1),
                                                         std::make_pair(i, j - 1), std::make_pair(i, j + 1),
                                                         std::make_pair(i + 1, j - 1), std::make_pair(i + 1, j)}};
             for (const std::pair<int, int>& nbr : nbrs) {
-                if (isValidCoor(nbr.first, nbr.second)) {
-                    neighbors_[index][k] = nbr.first * extended_board_size_ + nbr.second;
-                    ++k;
-                }
+                if (isValidCoor(nbr.first, nbr.second)) { neighbors[index].add(nbr.first * extended_board_size_ + nbr.second); }
             }
-            neighbors_[index][k] = -1;
         }
     }
 }
@@ -386,7 +384,6 @@ bool HavannahEnv::isCycle(const HavannahPath* path, const HavannahAction& last_a
 
     // check if there is an interior cell
     for (int neighbor : neighbors_[pos]) {
-        if (neighbor == -1) { break; }
         if (computeOwnNeighbors(neighbor, player) == 6) { return true; }
     }
 
@@ -398,7 +395,6 @@ int HavannahEnv::computeOwnNeighbors(int pos, Player player) const
 {
     int count = 0;
     for (int neighbor : neighbors_[pos]) {
-        if (neighbor == -1) { break; }
         if (cells_[neighbor].getPlayer() == player) { count++; }
     }
     return count;
@@ -2,6 +2,7 @@
 
 #include "base_env.h"
 #include "configuration.h"
+#include <array>
 #include <bitset>
 #include <string>
 #include <utility>
@@ -16,6 +17,8 @@ const int kMinHavannahBoardSize = 4;
 const int kMaxExtendedHavannahBoardSize = kMaxHavannahBoardSize * 2 - 1;
 
 typedef std::bitset<kMaxExtendedHavannahBoardSize * kMaxExtendedHavannahBoardSize> HavannahBitboard;
+typedef NeighborList<6> HavannahNeighborList;
+typedef std::array<HavannahNeighborList, kMaxExtendedHavannahBoardSize * kMaxExtendedHavannahBoardSize> HavannahNeighborTable;
 
 class HavannahAction : public BaseBoardAction<kHavannahNumPlayer> {
 public:
@@ -132,7 +135,7 @@ private:
 private:
     inline bool isSwappable() const { return (config::env_havannah_use_swap_rule && actions_.size() == 1); }
     Player updateWinner(const HavannahAction& action);
-    void calculateNeighbors();
+    void calculateNeighbors(HavannahNeighborTable& neighbors) const;
     bool isValidCell(const HavannahCell& cell) const;
     bool isValidCoor(int i, int j) const;
     std::string getCoordinateString() const;
@@ -148,7 +151,7 @@ private:
     Player winner_;
     std::vector<HavannahCell> cells_;
     std::vector<HavannahPath> paths_;
-    std::vector<std::array<int, 7>> neighbors_;
+    const HavannahNeighborList* neighbors_;
 
     GamePair<HavannahBitboard> bitboard_pair_;
     std::vector<GamePair<HavannahBitboard>> bitboard_history_;
@@ -3,6 +3,8 @@
 #include "random.h"
 #include "sgf_loader.h"
 #include <algorithm>
+#include <mutex>
+#include <random>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -11,27 +13,51 @@ namespace minizero::env::rubiks {
 
 using namespace minizero::utils;
 
+std::once_flag hash_key_flag;
+std::array<std::array<RubiksHashKey, kCubeFace>, kMaxRubiksNumStickers> sticker_hash_key;
+std::array<RubiksTurnTable, kMaxRubiksBoardSize + 1> turn_tables;
+std::array<std::once_flag, kMaxRubiksBoardSize + 1> turn_table_flags;
+
+void initialize()
+{
+    std::call_once(hash_key_flag, []() {
+        std::mt19937_64 generator;
+        generator.seed(0);
+        for (auto& sticker_keys : sticker_hash_key) {
+            for (auto& key : sticker_keys) { key = generator(); }
+        }
+    });
+}
+
+RubiksHashKey getRubiksStickerHashKey(int sticker, int color)
+{
+    assert(sticker >= 0 && sticker < kMaxRubiksNumStickers);
+    assert(color >= 0 && color < kCubeFace);
+    return sticker_hash_key[sticker][color];
+}
+
 void RubiksEnv::reset(int seed, int scramble)
 {
+    // turn tables are built once per board size and shared by all environments
+    std::call_once(turn_table_flags[board_size_], [this]() { calculateTurnTable(turn_tables[board_size_]); });
+    turn_table_ = &turn_tables[board_size_];
+
     turn_ = Player::kPlayer1;
-    random_.seed(seed_ = seed);
-    board_.resize(kCubeFace);
+    seed_ = seed;
     scramble_ = scramble;
-    for (int face = 0; face < kCubeFace; face++) {
-        board_[face].resize(board_size_);
-        for (int row = 0; row < board_size_; row++) {
-            board_[face][row].resize(board_size_);
-        }
-    }
+    hash_key_ = 0;
     for (int face = 0; face < kCubeFace; face++) {
         for (int row = 0; row < board_size_; row++) {
             for (int col = 0; col < board_size_; col++) {
-                board_[face][row][col] = kCubeColorOrder[face];
+                int sticker = getStickerIndex(face, row, col);
+                board_[sticker] = face;
+                hash_key_ ^= getRubiksStickerHashKey(sticker, face);
             }
         }
     }
+    std::mt19937 random(seed);
     while (scramble--) {
-        act(RubiksAction(std::uniform_int_distribution<int>(0, board_size_ / 2 * 12 - 1)(random_), turn_));
+        act(RubiksAction(std::uniform_int_distribution<int>(0, board_size_ / 2 * 12 - 1)(random), turn_));
     }
     actions_.clear();
 }
@@ -39,11 +65,14 @@ void RubiksEnv::reset(int seed, int scramble)
 bool RubiksEnv::act(const RubiksAction& action)
 {
     actions_.push_back(action);
-    int id = action.getActionID();
-    int face = id % 6;
-    int layer = id / 12 + 1;
-    bool prime = (id % 12) >= 6;
-    rotate(face, layer, prime);
+    const RubiksTurn& turn = (*turn_table_)[action.getActionID()];
+    const RubiksStickers old_board = board_;
+    for (int i = 0; i < turn.size_; ++i) {
+        int target = turn.targets_[i];
+        hash_key_ ^= getRubiksStickerHashKey(target, board_[target]);
+        board_[target] = old_board[turn.sources_[i]];
+        hash_key_ ^= getRubiksStickerHashKey(target, board_[target]);
+    }
     return true;
 }
 
@@ -81,12 +110,8 @@ float RubiksEnv::getEvalScore(bool is_resign /*= false*/) const
 bool RubiksEnv::checkSolved() const
 {
     for (int face = 0; face < kCubeFace; face++) {
-        for (int row = 0; row < board_size_; row++) {
-            for (int col = 0; col < board_size_; col++) {
-                if (board_[face][row][col] != kCubeColorOrder[face]) {
-                    return false;
-                }
-            }
+        for (int i = 0; i < board_size_ * board_size_; i++) {
+            if (board_[face * board_size_ * board_size_ + i] != face) { return false; }
         }
     }
     return true;
@@ -94,16 +119,9 @@ bool RubiksEnv::checkSolved() const
 
 std::vector<float> RubiksEnv::getFeatures(utils::Rotation rotation /*= utils::Rotation::kRotationNone*/) const
 {
-    std::vector<float> features;
-    for (int color = 0; color < kCubeFace; ++color) {
-        for (int face = 0; face < kCubeFace; face++) {
-            for (int row = 0; row < board_size_; row++) {
-                for (int col = 0; col < board_size_; col++) {
-                    features.push_back(board_[face][row][col] == kCubeColorOrder[color] ? 1.0f : 0.0f);
-                }
-            }
-        }
-    }
+    const int num_stickers = kCubeFace * board_size_ * board_size_;
+    std::vector<float> features(kCubeFace * num_stickers, 0.0f);
+    for (int sticker = 0; sticker < num_stickers; ++sticker) { features[board_[sticker] * num_stickers + sticker] = 1.0f; }
     return features;
 }
 
@@ -113,20 +131,38 @@ std::vector<float> RubiksEnv::getActionFeatures(const RubiksAction& action, util
     return {};
 }
 
-void RubiksEnv::transpose(int face)
+void RubiksEnv::calculateTurnTable(RubiksTurnTable& turn_table) const
+{
+    // apply each rotation to a cube labeled by sticker index, then record the stickers it moves
+    for (int id = 0; id < board_size_ / 2 * 12; ++id) {
+        RubiksStickers stickers;
+        for (int sticker = 0; sticker < kCubeFace * board_size_ * board_size_; ++sticker) { stickers[sticker] = sticker; }
+        rotate(stickers, id % 6, id / 12 + 1, (id % 12) >= 6);
+
+        RubiksTurn& turn = turn_table[id];
+        for (int sticker = 0; sticker < kCubeFace * board_size_ * board_size_; ++sticker) {
+            if (stickers[sticker] == sticker) { continue; }
+            turn.targets_[turn.size_] = sticker;
+            turn.sources_[turn.size_] = stickers[sticker];
+            ++turn.size_;
+        }
+    }
+}
+
+void RubiksEnv::transpose(RubiksStickers& stickers, int face) const
 {
     for (int row = 0; row < board_size_; row++) {
         for (int col = row + 1; col < board_size_; col++) {
-            std::swap(board_[face][row][col], board_[face][col][row]);
+            std::swap(stickers[getStickerIndex(face, row, col)], stickers[getStickerIndex(face, col, row)]);
         }
     }
 }
 
-void RubiksEnv::rotate(int face, int layer, bool prime)
+void RubiksEnv::rotate(RubiksStickers& stickers, int face, int layer, bool prime) const
 {
     const std::vector<std::vector<int>>& sides = kCubeRotateSide[face];
     if (prime) {
-        transpose(face);
+        transpose(stickers, face);
         for (int i = 2; i >= 0; i--) {
             for (int ly = 0; ly < layer; ly++) {
                 for (int bs = 0; bs < board_size_; bs++) {
@@ -134,18 +170,18 @@ void RubiksEnv::rotate(int face, int layer, bool prime)
                     int ay = sides[i][1] ? (sides[i][2] ? board_size_ - ly - 1 : ly) : (sides[i][3] ? board_size_ - bs - 1 : bs);
                     int bx = sides[i + 1][1] ? (sides[i + 1][3] ? board_size_ - bs - 1 : bs) : (sides[i + 1][2] ? board_size_ - ly - 1 : ly);
                     int by = sides[i + 1][1] ? (sides[i + 1][2] ? board_size_ - ly - 1 : ly) : (sides[i + 1][3] ? board_size_ - bs - 1 : bs);
-                    std::swap(board_[sides[i][0]][ax][ay], board_[sides[i + 1][0]][bx][by]);
+                    std::swap(stickers[getStickerIndex(sides[i][0], ax, ay)], stickers[getStickerIndex(sides[i + 1][0], bx, by)]);
                 }
             }
         }
     }
     for (int i = 0; i < board_size_ / 2; i++) {
         for (int j = 0; j < board_size_; j++) {
-            std::swap(board_[face][i][j], board_[face][board_size_ - i - 1][j]);
+            std::swap(stickers[getStickerIndex(face, i, j)], stickers[getStickerIndex(face, board_size_ - i - 1, j)]);
         }
     }
     if (!prime) {
-        transpose(face);
+        transpose(stickers, face);
         for (int i = 1; i < 4; i++) {
             for (int ly = 0; ly < layer; ly++) {
                 for (int bs = 0; bs < board_size_; bs++) {
@@ -153,7 +189,7 @@ void RubiksEnv::rotate(int face, int layer, bool prime)
                     int ay = sides[i][1] ? (sides[i][2] ? board_size_ - ly - 1 : ly) : (sides[i][3] ? board_size_ - bs - 1 : bs);
                     int bx = sides[i - 1][1] ? (sides[i - 1][3] ? board_size_ - bs - 1 : bs) : (sides[i - 1][2] ? board_size_ - ly - 1 : ly);
                     int by = sides[i - 1][1] ? (sides[i - 1][2] ? board_size_ - ly - 1 : ly) : (sides[i - 1][3] ? board_size_ - bs - 1 : bs);
-                    std::swap(board_[sides[i][0]][ax][ay], board_[sides[i - 1][0]][bx][by]);
+                    std::swap(stickers[getStickerIndex(sides[i][0], ax, ay)], stickers[getStickerIndex(sides[i - 1][0], bx, by)]);
                 }
             }
         }
@@ -164,27 +200,28 @@ std::string RubiksEnv::toString() const
 {
     std::ostringstream oss;
     std::unordered_map<char, std::string> color_code_to_rgb({{'G', "\033[48;2;0;155;72m"}, {'W', "\033[48;2;255;255;255m"}, {'R', "\033[48;2;183;18;52m"}, {'Y', "\033[48;2;255;213;0m"}, {'B', "\033[48;2;0;70;173m"}, {'O', "\033[48;2;255;88;0m"}});
-    auto renderCell = [&](char color) {
+    auto renderCell = [&](int sticker) {
+        char color = kCubeColorOrder[board_[sticker]];
         if (!utils::isColorOutputEnabled()) { return std::string(2, color); }
         return color_code_to_rgb[color] + "  \033[m";
     };
     for (int row = 0; row < board_size_; row++) {
         for (int col = 0; col < board_size_; col++) oss << "  ";
         for (int col = 0; col < board_size_; col++) {
-            oss << renderCell(board_[0][row][col]);
+            oss << renderCell(getStickerIndex(0, row, col));
         }
         oss << std::endl;
     }
     for (int row = 0; row < board_size_; row++) {
         for (int col = 0; col < board_size_ * 4; col++) {
-            oss << renderCell(board_[col / board_size_ + 1][row][col % board_size_]);
+            oss << renderCell(getStickerIndex(col / board_size_ + 1, row, col % board_size_));
         }
         oss << std::endl;
     }
     for (int row = 0; row < board_size_; row++) {
         for (int col = 0; col < board_size_; col++) oss << "  ";
         for (int col = 0; col < board_size_; col++) {
-            oss << renderCell(board_[5][row][col]);
+            oss << renderCell(getStickerIndex(5, row, col));
         }
         oss << std::endl;
     }
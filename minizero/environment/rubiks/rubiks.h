@@ -3,6 +3,7 @@
 #include "base_env.h"
 #include "configuration.h"
 #include "random.h"
+#include <array>
 #include <iostream>
 #include <string>
 #include <utility>
@@ -16,6 +17,29 @@ const int kMaxRubiksBoardSize = 3;
 const int kMaxRotateNum = 30;
 
 const int kCubeFace = 6;
+const int kMaxRubiksNumStickers = kCubeFace * kMaxRubiksBoardSize * kMaxRubiksBoardSize;
+const int kMaxRubiksPolicySize = kMaxRubiksBoardSize / 2 * 12;
+
+typedef uint64_t RubiksHashKey;
+typedef std::array<uint8_t, kMaxRubiksNumStickers> RubiksStickers; // color index (0~5) of each sticker
+
+/**
+ *    A face turn is stored as the list of stickers it moves,
+ *    i.e., stickers[targets_[i]] := old_stickers[sources_[i]],
+ *    stickers that are not listed stay in place
+ */
+class RubiksTurn {
+public:
+    RubiksTurn() : size_(0) {}
+
+    int size_;
+    std::array<uint8_t, kMaxRubiksNumStickers> targets_;
+    std::array<uint8_t, kMaxRubiksNumStickers> sources_;
+};
+typedef std::array<RubiksTurn, kMaxRubiksPolicySize> RubiksTurnTable;
+
+void initialize();
+RubiksHashKey getRubiksStickerHashKey(int sticker, int color);
 
 /**
  *    Colors for each of the six faces of the cube:
@@ -128,6 +152,7 @@ public:
     RubiksEnv()
     {
         assert(getBoardSize() <= kMaxRubiksBoardSize);
+        initialize();
         reset();
     }
 
@@ -159,17 +184,20 @@ public:
 
     inline int getSeed() const { return seed_; }
     inline int getScramble() const { return scramble_; }
+    inline RubiksHashKey getHashKey() const { return hash_key_; }
 
     static void setUpEnv() { config::env_board_size = 3; }
 
 private:
-    void transpose(int face);
-    void rotate(int face, int layer, bool prime);
+    inline int getStickerIndex(int face, int row, int col) const { return (face * board_size_ + row) * board_size_ + col; }
+    void calculateTurnTable(RubiksTurnTable& turn_table) const;
+    void transpose(RubiksStickers& stickers, int face) const;
+    void rotate(RubiksStickers& stickers, int face, int layer, bool prime) const;
     bool checkSolved() const;
 
     /**
-     *    e.g. 3*3 cube: board_[6][3][3]
-     *   
+     *    e.g. 3*3 cube: board_[6 * 3 * 3], indexed by getStickerIndex(face, row, col)
+     *
      *            ______
      *           |      |
      *           |  0   |
@@ -182,9 +210,10 @@ private:
      *           |______|
      *
      */
-    std::vector<std::vector<std::vector<char>>> board_;
+    RubiksStickers board_;
+    const RubiksTurnTable* turn_table_;
+    RubiksHashKey hash_key_;
 
-    std::mt19937 random_;
     int seed_;
     int scramble_;
 };
@@ -1,5 +1,6 @@
 #pragma once
 #include <algorithm>
+#include <array>
 #include <cmath>
 #include <iostream>
 #include <limits>
@@ -99,6 +100,26 @@ private:
             sc += score;
         }
 
+        void applySlideUp(uint64_t& raw, int& sc, int i) const
+        {
+            raw |= toColumn(left) << (i << 2);
+            sc += score;
+        }
+
+        void applySlideDown(uint64_t& raw, int& sc, int i) const
+        {
+            raw |= toColumn(right) << (i << 2);
+            sc += score;
+        }
+
+        /**
+         * place a 16-bit row as a column, i.e., the kth tile of the row becomes the kth tile of the column
+         */
+        static uint64_t toColumn(int row)
+        {
+            return (uint64_t(row & 0x000f) << 0) | (uint64_t(row & 0x00f0) << 12) | (uint64_t(row & 0x0f00) << 24) | (uint64_t(row & 0xf000) << 36);
+        }
+
         static int calculateSlideLeft(int row[])
         {
             int top = 0;
@@ -231,17 +252,56 @@ public:
     }
     int slideUp()
     {
-        rotate(1);
-        int score = slideRight();
-        rotate(-1);
-        return score;
+        // the ith row of the transposed board is the ith column, from top to bottom
+        Bitboard transposed(raw_);
+        transposed.transpose();
+        uint64_t move = 0;
+        uint64_t prev = raw_;
+        int score = 0;
+        RowLookup::find(transposed.getRow(0)).applySlideUp(move, score, 0);
+        RowLookup::find(transposed.getRow(1)).applySlideUp(move, score, 1);
+        RowLookup::find(transposed.getRow(2)).applySlideUp(move, score, 2);
+        RowLookup::find(transposed.getRow(3)).applySlideUp(move, score, 3);
+        raw_ = move;
+        return (move != prev) ? score : -1;
     }
     int slideDown()
     {
-        rotate(1);
-        int score = slideLeft();
-        rotate(-1);
-        return score;
+        Bitboard transposed(raw_);
+        transposed.transpose();
+        uint64_t move = 0;
+        uint64_t prev = raw_;
+        int score = 0;
+        RowLookup::find(transposed.getRow(0)).applySlideDown(move, score, 0);
+        RowLookup::find(transposed.getRow(1)).applySlideDown(move, score, 1);
+        RowLookup::find(transposed.getRow(2)).applySlideDown(move, score, 2);
+        RowLookup::find(transposed.getRow(3)).applySlideDown(move, score, 3);
+        raw_ = move;
+        return (move != prev) ? score : -1;
+    }
+
+    /**
+     * apply all four actions to copies of the board at once, with each row and column looked up only once
+     * afterstates[opcode] is the board after the action, and rewards[opcode] is the reward or -1 if the action is illegal
+     */
+    void slideAll(std::array<Bitboard, 4>& afterstates, std::array<int, 4>& rewards) const
+    {
+        Bitboard transposed(raw_);
+        transposed.transpose();
+        uint64_t up = 0, right = 0, down = 0, left = 0;
+        int row_score = 0, column_score = 0;
+        for (int i = 0; i < 4; ++i) {
+            const RowLookup& row = RowLookup::find(getRow(i));
+            const RowLookup& column = RowLookup::find(transposed.getRow(i));
+            left |= uint64_t(row.left) << (i << 4);
+            right |= uint64_t(row.right) << (i << 4);
+            row_score += row.score;
+            up |= RowLookup::toColumn(column.left) << (i << 2);
+            down |= RowLookup::toColumn(column.right) << (i << 2);
+            column_score += column.score;
+        }
+        afterstates = {Bitboard(up), Bitboard(right), Bitboard(down), Bitboard(left)};
+        rewards = {(up != raw_) ? column_score : -1, (right != raw_) ? row_score : -1, (down != raw_) ? column_score : -1, (left != raw_) ? row_score : -1};
     }
 
     /**
@@ -25,9 +25,11 @@ void Puzzle2048Env::reset(int seed)
 
 bool Puzzle2048Env::act(const Puzzle2048Action& action, bool with_chance /* = true */)
 {
-    if (turn_ != Player::kPlayer1) { return false; }
-    int reward = board_.slide(action.getActionID());
+    if (turn_ != Player::kPlayer1 || action.getActionID() < 0 || action.getActionID() >= kPuzzle2048ActionSize) { return false; }
+    updateAfterstates();
+    int reward = afterstate_rewards_[action.getActionID()];
     if (reward == -1) { return false; }
+    board_ = afterstates_[action.getActionID()];
     actions_.push_back(action);
     reward_ = reward;
     total_reward_ += reward;
@@ -64,9 +66,11 @@ bool Puzzle2048Env::actChanceEvent()
 std::vector<Puzzle2048Action> Puzzle2048Env::getLegalActions() const
 {
     if (turn_ != Player::kPlayer1) { return {}; }
+    updateAfterstates();
     std::vector<Puzzle2048Action> actions;
-    for (int move = 0; move < 4; ++move) {
-        if (Bitboard(board_).slide(move) != -1) { actions.emplace_back(move, Player::kPlayer1); }
+    actions.reserve(kPuzzle2048ActionSize);
+    for (int move = 0; move < kPuzzle2048ActionSize; ++move) {
+        if (afterstate_rewards_[move] != -1) { actions.emplace_back(move, Player::kPlayer1); }
     }
     return actions;
 }
@@ -92,7 +96,9 @@ float Puzzle2048Env::getChanceEventProbability(const Puzzle2048Action& action) c
 
 bool Puzzle2048Env::isLegalAction(const Puzzle2048Action& action) const
 {
-    return turn_ == Player::kPlayer1 && Bitboard(board_).slide(action.getActionID()) != -1 && action.getPlayer() == Player::kPlayer1;
+    if (turn_ != Player::kPlayer1 || action.getPlayer() != Player::kPlayer1 || action.getActionID() < 0 || action.getActionID() >= kPuzzle2048ActionSize) { return false; }
+    updateAfterstates();
+    return afterstate_rewards_[action.getActionID()] != -1;
 }
 
 bool Puzzle2048Env::isLegalChanceEvent(const Puzzle2048Action& action) const
@@ -104,10 +110,8 @@ bool Puzzle2048Env::isLegalChanceEvent(const Puzzle2048Action& action) const
 
 bool Puzzle2048Env::isTerminal() const
 {
-    for (int move = 0; move < 4; ++move) {
-        if (Bitboard(board_).slide(move) != -1) { return false; }
-    }
-    return true;
+    updateAfterstates();
+    return std::all_of(afterstate_rewards_.begin(), afterstate_rewards_.end(), [](int reward) { return reward == -1; });
 }
 
 std::vector<float> Puzzle2048Env::getFeatures(utils::Rotation rotation /*= utils::Rotation::kRotationNone*/) const
@@ -147,6 +151,13 @@ std::string Puzzle2048Env::toString() const
     return oss.str();
 }
 
+void Puzzle2048Env::updateAfterstates() const
+{
+    if (afterstate_board_ == board_) { return; }
+    afterstate_board_ = board_;
+    board_.slideAll(afterstates_, afterstate_rewards_);
+}
+
 std::vector<float> Puzzle2048EnvLoader::getActionFeatures(const int pos, utils::Rotation rotation /*= utils::Rotation::kRotationNone*/) const
 {
     int hidden_size = kPuzzle2048BoardSize * kPuzzle2048BoardSize;
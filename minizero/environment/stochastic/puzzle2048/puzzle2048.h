@@ -3,6 +3,7 @@
 #include "bitboard.h"
 #include "stochastic_env.h"
 #include <algorithm>
+#include <array>
 #include <string>
 #include <vector>
 
@@ -83,7 +84,7 @@ protected:
 
 class Puzzle2048Env : public StochasticEnv<Puzzle2048Action> {
 public:
-    Puzzle2048Env() {}
+    Puzzle2048Env() : afterstate_board_(0) { afterstate_board_.slideAll(afterstates_, afterstate_rewards_); }
 
     void reset() override { reset(utils::Random::randInt()); }
     void reset(int seed) override;
@@ -142,9 +143,16 @@ public:
     }
 
 private:
+    void updateAfterstates() const;
+
     Bitboard board_;
     int reward_;
     int total_reward_;
+
+    // afterstates of all actions, computed once per board and reused by legality checks and act()
+    mutable Bitboard afterstate_board_;
+    mutable std::array<Bitboard, kPuzzle2048ActionSize> afterstates_;
+    mutable std::array<int, kPuzzle2048ActionSize> afterstate_rewards_;
 };
 
 class Puzzle2048EnvLoader : public StochasticEnvLoader<Puzzle2048Action, Puzzle2048Env> {
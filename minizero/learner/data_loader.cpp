@@ -4,7 +4,9 @@
 #include "random.h"
 #include "rotation.h"
 #include <algorithm>
-#include <fstream>
+#include <boost/iostreams/device/file.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
 #include <utility>
 
 namespace minizero::learner {
@@ -145,6 +147,9 @@ void DataLoaderThread::setAlphaZeroTrainingData(int batch_index)
     std::vector<float> policy = env_loader.getPolicy(pos, rotation);
     std::vector<float> value = env_loader.getValue(pos);
 
+    // positions of fast searches in playout cap randomization are only used for value training, i.e., no policy loss
+    if (!env_loader.isFullSearch(pos)) { std::fill(policy.begin(), policy.end(), 0.0f); }
+
     // write data to data_ptr
     getSharedData()->getDataPtr()->loss_scale_[batch_index] = loss_scale;
     getSharedData()->getDataPtr()->sampled_index_[2 * batch_index] = p.first;
@@ -173,8 +178,9 @@ void DataLoaderThread::setMuZeroTrainingData(int batch_index)
             action_features.insert(action_features.end(), tmp.begin(), tmp.end());
         }
 
-        // policy
+        // policy, no loss for positions of fast searches
         tmp = env_loader.getPolicy(pos + step, rotation);
+        if (!env_loader.isFullSearch(pos + step)) { std::fill(tmp.begin(), tmp.end(), 0.0f); }
         policy.insert(policy.end(), tmp.begin(), tmp.end());
 
         // value
@@ -215,7 +221,10 @@ void DataLoader::initialize()
 
 void DataLoader::loadDataFromFile(const std::string& file_name)
 {
-    std::ifstream fin(file_name, std::ifstream::in);
+    // self-play games are stored as a gzip stream if the file name ends with .gz
+    boost::iostreams::filtering_istream fin;
+    if (file_name.size() >= 3 && file_name.compare(file_name.size() - 3, 3, ".gz") == 0) { fin.push(boost::iostreams::gzip_decompressor()); }
+    fin.push(boost::iostreams::file_source(file_name, std::ios::in | std::ios::binary));
     for (std::string content; std::getline(fin, content);) { getSharedData()->env_strings_.push_back(content); }
 
     for (auto& t : slave_threads_) { t->start(); }
@@ -240,7 +249,7 @@ void DataLoader::updatePriority(int* sampled_index, float* batch_values)
         EnvironmentLoader& env_loader = getSharedData()->replay_buffer_.env_loaders_[env_id];
         for (int step = 0; step <= config::learner_muzero_unrolling_step; ++step) {
             float new_value = utils::invertValue(batch_values[step * config::learner_batch_size + batch_index]);
-            env_loader.setActionPairInfo(pos_id + step, "V", std::to_string(new_value));
+            env_loader.setValue(pos_id + step, new_value);
         }
         getSharedData()->replay_buffer_.position_priorities_[env_id][pos_id] = std::pow(env_loader.getPriority(pos_id), config::learner_per_alpha);
     }
@@ -1,5 +1,6 @@
 #!/usr/bin/env python
 
+import os
 import sys
 import time
 import torch
@@ -40,6 +41,8 @@ class MinizeroDadaLoader:
     def load_data(self, training_dir, start_iter, end_iter):
         for i in range(start_iter, end_iter + 1):
             file_name = f"{training_dir}/sgf/{i}.sgf"
+            if not os.path.isfile(file_name) and os.path.isfile(f"{file_name}.gz"):
+                file_name = f"{file_name}.gz"
             if file_name in self.data_list:
                 continue
             self.data_loader.load_data_from_file(file_name)
@@ -124,7 +127,8 @@ class Model:
                     'optimizer': self.optimizer.state_dict(),
                     'scheduler': self.scheduler.state_dict()}
         torch.save(snapshot, f"{training_dir}/model/weight_iter_{self.training_step}.pkl")
-        torch.jit.script(self.network.module).save(f"{training_dir}/model/weight_iter_{self.training_step}.pt")
+        torch.jit.script(self.network.module).save(f"{training_dir}/model/weight_iter_{self.training_step}.pt",
+                                                   _extra_files={"network_type_name": self.network.module.get_type_name()})
 
 
 def calculate_loss(network_output, label_policy, label_value, label_reward, loss_scale):
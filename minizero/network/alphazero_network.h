@@ -60,10 +60,11 @@ public:
         return index;
     }
 
-    std::vector<std::shared_ptr<NetworkOutput>> forward()
+    virtual std::vector<std::shared_ptr<NetworkOutput>> forward()
     {
         assert(batch_size_ > 0);
-        auto forward_result = network_.forward(std::vector<torch::jit::IValue>{torch::cat(tensor_input_).to(getDevice())}).toGenericDict();
+        torch::InferenceMode guard;
+        auto forward_result = network_.forward(std::vector<torch::jit::IValue>{toInputTensor(tensor_input_)}).toGenericDict();
 
         auto policy_output = forward_result.at("policy").toTensor().to(at::kCPU);
         auto policy_logits_output = forward_result.at("policy_logit").toTensor().to(at::kCPU);
@@ -10,15 +10,14 @@ namespace minizero::network {
 
 inline std::shared_ptr<Network> createNetwork(const std::string& nn_file_name, const int gpu_id)
 {
-    // TODO: how to speed up?
-    Network base_network;
-    base_network.loadModel(nn_file_name, -1);
+    // the model is loaded only once, by the network of the corresponding type
+    std::string network_type_name = Network::loadNetworkTypeName(nn_file_name, gpu_id);
 
     std::shared_ptr<Network> network;
-    if (base_network.getNetworkTypeName() == "alphazero") {
+    if (network_type_name == "alphazero") {
         network = std::make_shared<AlphaZeroNetwork>();
         std::dynamic_pointer_cast<AlphaZeroNetwork>(network)->loadModel(nn_file_name, gpu_id);
-    } else if (base_network.getNetworkTypeName() == "muzero" || base_network.getNetworkTypeName() == "muzero_atari") {
+    } else if (network_type_name == "muzero" || network_type_name == "muzero_atari") {
         network = std::make_shared<MuZeroNetwork>();
         std::dynamic_pointer_cast<MuZeroNetwork>(network)->loadModel(nn_file_name, gpu_id);
     } else {
@@ -0,0 +1,310 @@
+#include "inference_service.h"
+#include "configuration.h"
+#include "create_network.h"
+#include <cstdint>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <unistd.h>
+
+namespace minizero::network {
+
+InferenceService::InferenceService(const std::string& socket_path, int max_batch_size, int gpu_id)
+    : socket_path_(socket_path),
+      max_batch_size_(max_batch_size),
+      gpu_id_(gpu_id),
+      num_clients_(0),
+      num_forwards_(0),
+      num_rows_(0)
+{
+    // the initial model is kept until clients use another one
+    releaseModel(acquireModel(config::nn_file_name));
+}
+
+void InferenceService::run()
+{
+    ::unlink(socket_path_.c_str());
+    boost::asio::local::stream_protocol::acceptor acceptor(io_service_, boost::asio::local::stream_protocol::endpoint(socket_path_));
+    std::cerr << "[InferenceService] listen on " << socket_path_ << std::endl;
+
+    boost::thread_group threads;
+    threads.create_thread(boost::bind(&InferenceService::runBatcher, this));
+    while (true) {
+        std::shared_ptr<boost::asio::local::stream_protocol::socket> socket = std::make_shared<boost::asio::local::stream_protocol::socket>(io_service_);
+        acceptor.accept(*socket);
+        threads.create_thread(boost::bind(&InferenceService::handleClient, this, socket));
+    }
+}
+
+void InferenceService::handleClient(std::shared_ptr<boost::asio::local::stream_protocol::socket> socket)
+{
+    bool is_connected = false;
+    std::shared_ptr<Model> model;
+    try {
+        switchModel(model, *socket);
+        {
+            boost::lock_guard<boost::mutex> lock(mutex_);
+            ++num_clients_;
+            is_connected = true;
+        }
+
+        while (true) {
+            uint32_t batch_size = 0;
+            boost::asio::read(*socket, boost::asio::buffer(&batch_size, sizeof(batch_size)));
+            if (batch_size == 0) {
+                switchModel(model, *socket);
+                continue;
+            }
+
+            const std::shared_ptr<AlphaZeroNetwork>& network = model->network_;
+            std::shared_ptr<Request> request = std::make_shared<Request>(batch_size, model);
+            request->features_.resize(batch_size * network->getNumInputChannels() * network->getInputChannelHeight() * network->getInputChannelWidth());
+            boost::asio::read(*socket, boost::asio::buffer(request->features_));
+            {
+                boost::unique_lock<boost::mutex> lock(mutex_);
+                requests_.push_back(request);
+                request_cv_.notify_all();
+                response_cv_.wait(lock, [&request] { return request->is_done_; });
+            }
+            boost::asio::write(*socket, std::vector<boost::asio::const_buffer>{boost::asio::buffer(&batch_size, sizeof(batch_size)), boost::asio::buffer(request->outputs_)});
+        }
+    } catch (const boost::system::system_error&) {
+        // the client is disconnected
+    }
+
+    if (model) { releaseModel(model); }
+    boost::lock_guard<boost::mutex> lock(mutex_);
+    if (is_connected) { --num_clients_; }
+    request_cv_.notify_all();
+}
+
+void InferenceService::switchModel(std::shared_ptr<Model>& model, boost::asio::local::stream_protocol::socket& socket)
+{
+    // the client sends nothing else before receiving the hyper-parameters, so the buffer holds exactly the model file name
+    boost::asio::streambuf read_buffer;
+    boost::asio::read_until(socket, read_buffer, '\n');
+    std::istream is(&read_buffer);
+    std::string nn_file_name;
+    std::getline(is, nn_file_name);
+
+    std::shared_ptr<Model> new_model = acquireModel(nn_file_name);
+    if (model) { releaseModel(model); }
+    model = new_model;
+    boost::asio::write(socket, boost::asio::buffer(getHyperParameters(model->network_)));
+}
+
+std::shared_ptr<InferenceService::Model> InferenceService::acquireModel(const std::string& nn_file_name)
+{
+    std::shared_ptr<Model> model;
+    bool is_loading = false;
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        std::shared_ptr<Model>& entry = models_[nn_file_name];
+        if (!entry) {
+            entry = std::make_shared<Model>();
+            is_loading = true;
+        }
+        model = entry;
+        ++model->num_clients_;
+    }
+
+    if (!is_loading) {
+        // another connection is loading the model
+        boost::unique_lock<boost::mutex> lock(mutex_);
+        model_cv_.wait(lock, [&model] { return model->network_ != nullptr; });
+        return model;
+    }
+
+    // the model is loaded without holding the lock, so that the forwards of other models keep running
+    std::shared_ptr<Network> network = createNetwork(nn_file_name, gpu_id_);
+    if (network->getNetworkTypeName() != "alphazero") {
+        std::cerr << "[InferenceService] only alphazero networks are supported, but got " << network->getNetworkTypeName() << std::endl;
+        exit(-1);
+    }
+
+    boost::lock_guard<boost::mutex> lock(mutex_);
+    model->network_ = std::static_pointer_cast<AlphaZeroNetwork>(network);
+    model_cv_.notify_all();
+
+    // unload the models without clients, pending requests keep their own references until forwarded
+    for (auto it = models_.begin(); it != models_.end();) { it = (it->second->num_clients_ == 0 ? models_.erase(it) : std::next(it)); }
+    std::cerr << "[InferenceService] load model " << nn_file_name << ", models in use " << models_.size() << std::endl;
+    return model;
+}
+
+void InferenceService::releaseModel(const std::shared_ptr<Model>& model)
+{
+    boost::lock_guard<boost::mutex> lock(mutex_);
+    --model->num_clients_;
+}
+
+void InferenceService::runBatcher()
+{
+    while (true) {
+        std::shared_ptr<Model> model;
+        std::vector<std::shared_ptr<Request>> batch;
+        {
+            // wait shortly for the other clients, so that their requests are pooled into the same forward
+            boost::unique_lock<boost::mutex> lock(mutex_);
+            request_cv_.wait(lock, [this] { return !requests_.empty(); });
+            request_cv_.wait_for(lock, boost::chrono::microseconds(kInferenceServiceMaxWaitMicroseconds), [this] {
+                return static_cast<int>(requests_.size()) >= num_clients_ || getNumPendingRows() >= max_batch_size_;
+            });
+
+            // only requests of the same model are forwarded together, starting from the oldest request
+            model = requests_.front()->model_;
+            int num_rows = 0;
+            for (auto it = requests_.begin(); it != requests_.end();) {
+                if ((*it)->model_ != model || (!batch.empty() && num_rows + (*it)->batch_size_ > max_batch_size_)) {
+                    ++it;
+                    continue;
+                }
+                num_rows += (*it)->batch_size_;
+                batch.push_back(*it);
+                it = requests_.erase(it);
+            }
+            ++num_forwards_;
+            num_rows_ += num_rows;
+        }
+
+        forward(model, batch);
+
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        for (auto& request : batch) { request->is_done_ = true; }
+        response_cv_.notify_all();
+        if (num_forwards_ % 1000 == 0) {
+            std::cerr << "[InferenceService] clients " << num_clients_
+                      << " models " << models_.size()
+                      << " forwards " << num_forwards_
+                      << " average batch size " << num_rows_ * 1.0f / num_forwards_
+                      << " fill ratio " << num_rows_ * 1.0f / (num_forwards_ * max_batch_size_) << std::endl;
+        }
+    }
+}
+
+void InferenceService::forward(const std::shared_ptr<Model>& model, const std::vector<std::shared_ptr<Request>>& batch)
+{
+    // only the batcher forwards, and a loaded network is not modified afterwards
+    const std::shared_ptr<AlphaZeroNetwork>& network = model->network_;
+    const int input_size = network->getNumInputChannels() * network->getInputChannelHeight() * network->getInputChannelWidth();
+    for (auto& request : batch) {
+        for (int i = 0; i < request->batch_size_; ++i) { network->pushBack(std::vector<float>(request->features_.begin() + i * input_size, request->features_.begin() + (i + 1) * input_size)); }
+    }
+    std::vector<std::shared_ptr<NetworkOutput>> outputs = network->forward();
+
+    const int action_size = network->getActionSize();
+    int index = 0;
+    for (auto& request : batch) {
+        request->outputs_.resize(request->batch_size_ * (2 * action_size + 1));
+        auto it = request->outputs_.begin();
+        for (int i = 0; i < request->batch_size_; ++i) {
+            std::shared_ptr<AlphaZeroNetworkOutput> output = std::static_pointer_cast<AlphaZeroNetworkOutput>(outputs[index++]);
+            it = std::copy(output->policy_.begin(), output->policy_.end(), it);
+            it = std::copy(output->policy_logits_.begin(), output->policy_logits_.end(), it);
+            *it++ = output->value_;
+        }
+    }
+}
+
+std::string InferenceService::getHyperParameters(const std::shared_ptr<AlphaZeroNetwork>& network) const
+{
+    std::ostringstream oss;
+    oss << network->getNumInputChannels() << " "
+        << network->getInputChannelHeight() << " "
+        << network->getInputChannelWidth() << " "
+        << network->getNumHiddenChannels() << " "
+        << network->getHiddenChannelHeight() << " "
+        << network->getHiddenChannelWidth() << " "
+        << network->getNumBlocks() << " "
+        << network->getActionSize() << " "
+        << network->getNumValueHiddenChannels() << " "
+        << network->getDiscreteValueSize() << " "
+        << network->getGameName() << " "
+        << network->getNetworkTypeName() << std::endl;
+    return oss.str();
+}
+
+int InferenceService::getNumPendingRows() const
+{
+    int num_rows = 0;
+    for (const auto& request : requests_) { num_rows += request->batch_size_; }
+    return num_rows;
+}
+
+void RemoteAlphaZeroNetwork::loadModel(const std::string& nn_file_name, const int gpu_id)
+{
+    assert(batch_size_ == 0); // should avoid loading model when batch size is not 0
+    gpu_id_ = gpu_id;
+    network_file_name_ = nn_file_name;
+
+    // the first model is sent as the handshake of a new connection, later models switch the model of the same connection
+    const std::string message = nn_file_name + "\n";
+    try {
+        if (!socket_) {
+            socket_ = std::make_unique<boost::asio::local::stream_protocol::socket>(io_service_);
+            socket_->connect(boost::asio::local::stream_protocol::endpoint(socket_path_));
+            boost::asio::write(*socket_, boost::asio::buffer(message));
+        } else {
+            uint32_t switch_marker = 0;
+            boost::asio::write(*socket_, std::vector<boost::asio::const_buffer>{boost::asio::buffer(&switch_marker, sizeof(switch_marker)), boost::asio::buffer(message)});
+        }
+        readHyperParameters();
+    } catch (const boost::system::system_error& e) {
+        std::cerr << "Failed to connect to the inference service " << socket_path_ << ": " << e.what() << std::endl;
+        exit(-1);
+    }
+    clear();
+}
+
+void RemoteAlphaZeroNetwork::preloadModel(const std::string& socket_path, const std::string& nn_file_name)
+{
+    // a temporary connection lets the service load the model, which is kept after disconnecting until another model is loaded,
+    // so that the following switch of the running networks does not wait for the loading
+    RemoteAlphaZeroNetwork network(socket_path);
+    network.loadModel(nn_file_name, -1);
+}
+
+void RemoteAlphaZeroNetwork::readHyperParameters()
+{
+    // the service sends nothing else before the hyper-parameters are received
+    boost::asio::streambuf read_buffer;
+    boost::asio::read_until(*socket_, read_buffer, '\n');
+    std::istream is(&read_buffer);
+    is >> num_input_channels_ >> input_channel_height_ >> input_channel_width_
+        >> num_hidden_channels_ >> hidden_channel_height_ >> hidden_channel_width_
+        >> num_blocks_ >> action_size_ >> num_value_hidden_channels_ >> discrete_value_size_
+        >> game_name_ >> network_type_name_;
+}
+
+std::vector<std::shared_ptr<NetworkOutput>> RemoteAlphaZeroNetwork::forward()
+{
+    assert(batch_size_ > 0);
+    torch::Tensor input = torch::cat(tensor_input_).contiguous();
+    uint32_t batch_size = batch_size_;
+    const int policy_size = getActionSize();
+    std::vector<float> outputs(batch_size * (2 * policy_size + 1));
+    try {
+        boost::asio::write(*socket_, std::vector<boost::asio::const_buffer>{boost::asio::buffer(&batch_size, sizeof(batch_size)), boost::asio::buffer(input.data_ptr<float>(), input.numel() * sizeof(float))});
+        boost::asio::read(*socket_, boost::asio::buffer(&batch_size, sizeof(batch_size)));
+        boost::asio::read(*socket_, boost::asio::buffer(outputs));
+    } catch (const boost::system::system_error& e) {
+        std::cerr << "Lost connection to the inference service " << socket_path_ << ": " << e.what() << std::endl;
+        exit(-1);
+    }
+
+    std::vector<std::shared_ptr<NetworkOutput>> network_outputs;
+    auto it = outputs.begin();
+    for (int i = 0; i < batch_size_; ++i) {
+        network_outputs.emplace_back(std::make_shared<AlphaZeroNetworkOutput>(policy_size));
+        auto alphazero_network_output = std::static_pointer_cast<AlphaZeroNetworkOutput>(network_outputs.back());
+        std::copy(it, it + policy_size, alphazero_network_output->policy_.begin());
+        std::copy(it + policy_size, it + 2 * policy_size, alphazero_network_output->policy_logits_.begin());
+        alphazero_network_output->value_ = *(it + 2 * policy_size);
+        it += 2 * policy_size + 1;
+    }
+
+    clear();
+    return network_outputs;
+}
+
+} // namespace minizero::network
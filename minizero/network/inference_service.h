@@ -0,0 +1,101 @@
+#pragma once
+
+#include "alphazero_network.h"
+#include <boost/asio.hpp>
+#include <boost/thread.hpp>
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace minizero::network {
+
+const int kInferenceServiceMaxWaitMicroseconds = 2000;
+
+/*
+ * InferenceService runs AlphaZero networks for the self-play processes on the same machine
+ * requests from all connected processes using the same model are pooled into one forward, so that batches are filled across processes
+ * one network is kept for each model in use, and models are loaded by the connection requesting them without pausing the forwards
+ * of other models; a model without clients is unloaded when another model is loaded
+ * protocol over a unix domain socket, in the native byte order since both ends are on the same machine:
+ *   handshake: the client sends "nn_file_name\n" and waits for a line of network hyper-parameters
+ *   request:   uint32 batch size, followed by (batch size * input size) floats of features
+ *   response:  uint32 batch size, followed by (batch size * (2 * action size + 1)) floats of policy, policy logits, and value
+ *   switch:    uint32 0, followed by "nn_file_name\n", answered by a line of network hyper-parameters as the handshake
+ */
+class InferenceService {
+public:
+    InferenceService(const std::string& socket_path, int max_batch_size, int gpu_id);
+
+    void run();
+
+private:
+    class Model {
+    public:
+        Model() : num_clients_(0) {}
+
+        int num_clients_;
+        std::shared_ptr<AlphaZeroNetwork> network_; // nullptr until loaded
+    };
+
+    class Request {
+    public:
+        Request(int batch_size, const std::shared_ptr<Model>& model) : batch_size_(batch_size), is_done_(false), model_(model) {}
+
+        int batch_size_;
+        bool is_done_;
+        std::shared_ptr<Model> model_;
+        std::vector<float> features_;
+        std::vector<float> outputs_;
+    };
+
+    void handleClient(std::shared_ptr<boost::asio::local::stream_protocol::socket> socket);
+    void switchModel(std::shared_ptr<Model>& model, boost::asio::local::stream_protocol::socket& socket);
+    std::shared_ptr<Model> acquireModel(const std::string& nn_file_name);
+    void releaseModel(const std::shared_ptr<Model>& model);
+    void runBatcher();
+    void forward(const std::shared_ptr<Model>& model, const std::vector<std::shared_ptr<Request>>& batch);
+    std::string getHyperParameters(const std::shared_ptr<AlphaZeroNetwork>& network) const;
+    int getNumPendingRows() const;
+
+    std::string socket_path_;
+    int max_batch_size_;
+    int gpu_id_;
+    int num_clients_;
+    long long num_forwards_;
+    long long num_rows_;
+    std::map<std::string, std::shared_ptr<Model>> models_;
+    std::deque<std::shared_ptr<Request>> requests_;
+    boost::mutex mutex_;
+    boost::condition_variable request_cv_;
+    boost::condition_variable response_cv_;
+    boost::condition_variable model_cv_;
+    boost::asio::io_service io_service_;
+};
+
+/*
+ * RemoteAlphaZeroNetwork is the client of InferenceService, it forwards batches through the service instead of a local model
+ * the connection is kept when switching models, and preloadModel lets the service load a model before the switch
+ */
+class RemoteAlphaZeroNetwork : public AlphaZeroNetwork {
+public:
+    RemoteAlphaZeroNetwork(const std::string& socket_path)
+        : socket_path_(socket_path)
+    {
+    }
+
+    void loadModel(const std::string& nn_file_name, const int gpu_id) override;
+    std::vector<std::shared_ptr<NetworkOutput>> forward() override;
+
+    static void preloadModel(const std::string& socket_path, const std::string& nn_file_name);
+
+private:
+    void readHyperParameters();
+
+    std::string socket_path_;
+    boost::asio::io_service io_service_;
+    std::unique_ptr<boost::asio::local::stream_protocol::socket> socket_;
+};
+
+} // namespace minizero::network
@@ -17,15 +17,16 @@ public:
     float reward_;
     std::vector<float> policy_;
     std::vector<float> policy_logits_;
-    std::vector<float> hidden_state_;
+    const float* hidden_state_;        // the row of this output in hidden_state_batch_
+    torch::Tensor hidden_state_batch_; // the contiguous hidden states of the whole batch, shared by all its outputs
 
-    MuZeroNetworkOutput(int policy_size, int hidden_state_size)
+    MuZeroNetworkOutput(int policy_size)
     {
         value_ = 0.0f;
         reward_ = 0.0f;
         policy_.resize(policy_size, 0.0f);
         policy_logits_.resize(policy_size, 0.0f);
-        hidden_state_.resize(hidden_state_size, 0.0f);
+        hidden_state_ = nullptr;
     }
 };
 
@@ -35,6 +36,7 @@ public:
     {
         num_action_feature_channels_ = -1;
         initial_input_batch_size_ = recurrent_input_batch_size_ = 0;
+        recurrent_batch_capacity_ = 0;
         initial_tensor_input_.clear();
         initial_tensor_input_.reserve(kReserved_batch_size);
         recurrent_tensor_feature_input_.clear();
@@ -51,6 +53,9 @@ public:
         num_action_feature_channels_ = network_.get_method("get_num_action_feature_channels")(dummy).toInt();
         initial_input_batch_size_ = 0;
         recurrent_input_batch_size_ = 0;
+        recurrent_batch_capacity_ = 0; // the shapes may differ from the previous model
+        recurrent_feature_batch_input_ = torch::Tensor();
+        recurrent_action_batch_input_ = torch::Tensor();
     }
 
     std::string toString() const override
@@ -75,27 +80,36 @@ public:
         return index;
     }
 
-    int pushBackRecurrentData(std::vector<float> features, std::vector<float> actions)
+    int pushBackRecurrentData(const float* hidden_state, const std::vector<float>& actions)
     {
-        assert(static_cast<int>(features.size()) == getNumHiddenChannels() * getHiddenChannelHeight() * getHiddenChannelWidth());
+        // the hidden state and the actions are copied once from the caller's storage, e.g., the slab of the search tree,
+        // into their row of the batch input; rows beyond its capacity, i.e., before it grows to the batch size, are kept as separate tensors
         assert(static_cast<int>(actions.size()) == getNumActionFeatureChannels() * getHiddenChannelHeight() * getHiddenChannelWidth());
 
         int index;
         {
             std::lock_guard<std::mutex> lock(recurrent_mutex_);
             index = recurrent_input_batch_size_++;
-            recurrent_tensor_feature_input_.resize(recurrent_input_batch_size_);
-            recurrent_tensor_action_input_.resize(recurrent_input_batch_size_);
+            if (index >= recurrent_batch_capacity_) {
+                recurrent_tensor_feature_input_.resize(index - recurrent_batch_capacity_ + 1);
+                recurrent_tensor_action_input_.resize(index - recurrent_batch_capacity_ + 1);
+            }
+        }
+        if (index < recurrent_batch_capacity_) {
+            const int hidden_state_size = getNumHiddenChannels() * getHiddenChannelHeight() * getHiddenChannelWidth();
+            std::copy(hidden_state, hidden_state + hidden_state_size, recurrent_feature_batch_input_.data_ptr<float>() + index * hidden_state_size);
+            std::copy(actions.begin(), actions.end(), recurrent_action_batch_input_.data_ptr<float>() + index * actions.size());
+        } else {
+            recurrent_tensor_feature_input_[index - recurrent_batch_capacity_] = torch::from_blob(const_cast<float*>(hidden_state), {1, getNumHiddenChannels(), getHiddenChannelHeight(), getHiddenChannelWidth()}).clone();
+            recurrent_tensor_action_input_[index - recurrent_batch_capacity_] = torch::from_blob(const_cast<float*>(actions.data()), {1, getNumActionFeatureChannels(), getHiddenChannelHeight(), getHiddenChannelWidth()}).clone();
         }
-        recurrent_tensor_feature_input_[index] = torch::from_blob(features.data(), {1, getNumHiddenChannels(), getHiddenChannelHeight(), getHiddenChannelWidth()}).clone();
-        recurrent_tensor_action_input_[index] = torch::from_blob(actions.data(), {1, getNumActionFeatureChannels(), getHiddenChannelHeight(), getHiddenChannelWidth()}).clone();
         return index;
     }
 
     inline std::vector<std::shared_ptr<NetworkOutput>> initialInference()
     {
         assert(initial_input_batch_size_ > 0);
-        auto outputs = forward("initial_inference", {torch::cat(initial_tensor_input_).to(getDevice())}, initial_input_batch_size_);
+        auto outputs = forward("initial_inference", {toInputTensor(initial_tensor_input_)}, initial_input_batch_size_);
         initial_tensor_input_.clear();
         initial_tensor_input_.reserve(kReserved_batch_size);
         initial_input_batch_size_ = 0;
@@ -105,9 +119,27 @@ public:
     inline std::vector<std::shared_ptr<NetworkOutput>> recurrentInference()
     {
         assert(recurrent_input_batch_size_ > 0);
-        auto outputs = forward("recurrent_inference",
-                               {{torch::cat(recurrent_tensor_feature_input_).to(getDevice())}, {torch::cat(recurrent_tensor_action_input_).to(getDevice())}},
-                               recurrent_input_batch_size_);
+        const int batch_size = recurrent_input_batch_size_;
+        torch::Tensor feature_input, action_input;
+        if (batch_size <= recurrent_batch_capacity_) {
+            feature_input = recurrent_feature_batch_input_.narrow(0, 0, batch_size);
+            action_input = recurrent_action_batch_input_.narrow(0, 0, batch_size);
+        } else {
+            if (recurrent_batch_capacity_ > 0) {
+                recurrent_tensor_feature_input_.insert(recurrent_tensor_feature_input_.begin(), recurrent_feature_batch_input_);
+                recurrent_tensor_action_input_.insert(recurrent_tensor_action_input_.begin(), recurrent_action_batch_input_);
+            }
+            feature_input = torch::cat(recurrent_tensor_feature_input_);
+            action_input = torch::cat(recurrent_tensor_action_input_);
+        }
+        auto outputs = forward("recurrent_inference", {{toInputTensor(feature_input)}, {toInputTensor(action_input)}}, batch_size);
+
+        // grow the batch input to this batch size, so that the following batches are written to it directly
+        if (batch_size > recurrent_batch_capacity_) {
+            recurrent_feature_batch_input_ = torch::empty({batch_size, getNumHiddenChannels(), getHiddenChannelHeight(), getHiddenChannelWidth()});
+            recurrent_action_batch_input_ = torch::empty({batch_size, getNumActionFeatureChannels(), getHiddenChannelHeight(), getHiddenChannelWidth()});
+            recurrent_batch_capacity_ = batch_size;
+        }
         recurrent_tensor_feature_input_.clear();
         recurrent_tensor_feature_input_.reserve(kReserved_batch_size);
         recurrent_tensor_action_input_.clear();
@@ -125,12 +157,13 @@ protected:
     {
         assert(network_.find_method(method));
 
+        torch::InferenceMode guard;
         auto forward_result = network_.get_method(method)(inputs).toGenericDict();
         auto policy_output = forward_result.at("policy").toTensor().to(at::kCPU);
         auto policy_logits_output = forward_result.at("policy_logit").toTensor().to(at::kCPU);
         auto value_output = forward_result.at("value").toTensor().to(at::kCPU);
         auto reward_output = (forward_result.contains("reward") ? forward_result.at("reward").toTensor().to(at::kCPU) : torch::zeros(0));
-        auto hidden_state_output = forward_result.at("hidden_state").toTensor().to(at::kCPU);
+        auto hidden_state_output = forward_result.at("hidden_state").toTensor().to(at::kCPU).contiguous();
         assert(policy_output.numel() == batch_size * getActionSize());
         assert(policy_logits_output.numel() == batch_size * getActionSize());
         assert((getNetworkTypeName() != "muzero_atari" && value_output.numel() == batch_size) || (getNetworkTypeName() == "muzero_atari" && value_output.numel() == batch_size * getDiscreteValueSize()));
@@ -141,7 +174,7 @@ protected:
         const int hidden_state_size = getNumHiddenChannels() * getHiddenChannelHeight() * getHiddenChannelWidth();
         std::vector<std::shared_ptr<NetworkOutput>> network_outputs;
         for (int i = 0; i < batch_size; ++i) {
-            network_outputs.emplace_back(std::make_shared<MuZeroNetworkOutput>(policy_size, hidden_state_size));
+            network_outputs.emplace_back(std::make_shared<MuZeroNetworkOutput>(policy_size));
             auto muzero_network_output = std::static_pointer_cast<MuZeroNetworkOutput>(network_outputs.back());
 
             std::copy(policy_output.data_ptr<float>() + i * policy_size,
@@ -150,9 +183,8 @@ protected:
             std::copy(policy_logits_output.data_ptr<float>() + i * policy_size,
                       policy_logits_output.data_ptr<float>() + (i + 1) * policy_size,
                       muzero_network_output->policy_logits_.begin());
-            std::copy(hidden_state_output.data_ptr<float>() + i * hidden_state_size,
-                      hidden_state_output.data_ptr<float>() + (i + 1) * hidden_state_size,
-                      muzero_network_output->hidden_state_.begin());
+            muzero_network_output->hidden_state_batch_ = hidden_state_output;
+            muzero_network_output->hidden_state_ = hidden_state_output.data_ptr<float>() + i * hidden_state_size;
 
             if (getNetworkTypeName() == "muzero_atari") {
                 int start_value = -getDiscreteValueSize() / 2;
@@ -180,11 +212,14 @@ protected:
     int num_action_feature_channels_;
     int initial_input_batch_size_;
     int recurrent_input_batch_size_;
+    int recurrent_batch_capacity_;
     std::mutex initial_mutex_;
     std::mutex recurrent_mutex_;
     std::vector<torch::Tensor> initial_tensor_input_;
     std::vector<torch::Tensor> recurrent_tensor_feature_input_;
     std::vector<torch::Tensor> recurrent_tensor_action_input_;
+    torch::Tensor recurrent_feature_batch_input_; // the hidden states of the batch, written row by row in pushBackRecurrentData
+    torch::Tensor recurrent_action_batch_input_;  // the action features of the batch
 
     const int kReserved_batch_size = 4096;
 };
@@ -1,4 +1,11 @@
 #include "network.h"
+#include "configuration.h"
+#include <ATen/Parallel.h>
+#include <caffe2/serialize/inline_container.h>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <utility>
 
 namespace minizero::network {
 
@@ -16,14 +23,8 @@ void Network::loadModel(const std::string& nn_file_name, const int gpu_id)
     gpu_id_ = gpu_id;
     network_file_name_ = nn_file_name;
 
-    // load model weights
-    try {
-        network_ = torch::jit::load(network_file_name_, getDevice());
-        network_.eval();
-    } catch (const c10::Error& e) {
-        std::cerr << e.msg() << std::endl;
-        assert(false);
-    }
+    // load model weights, shared with other networks on the same device
+    network_ = loadModule(network_file_name_, gpu_id_);
 
     // network hyper-parameter
     std::vector<torch::jit::IValue> dummy;
@@ -41,6 +42,85 @@ void Network::loadModel(const std::string& nn_file_name, const int gpu_id)
     network_type_name_ = network_.get_method("get_type_name")(dummy).toString()->string();
 }
 
+std::string Network::loadNetworkTypeName(const std::string& nn_file_name, const int gpu_id)
+{
+    // models saved with the type name as an extra file are identified without loading parameters
+    try {
+        caffe2::serialize::PyTorchStreamReader reader(nn_file_name);
+        if (reader.hasRecord("extra/network_type_name")) {
+            auto record = reader.getRecord("extra/network_type_name");
+            return std::string(static_cast<const char*>(std::get<0>(record).get()), std::get<1>(record));
+        }
+    } catch (const c10::Error& e) {
+        std::cerr << e.msg() << std::endl;
+        assert(false);
+    }
+
+    // older models have to be loaded, the module is kept for the following loadModel on the same device
+    std::vector<torch::jit::IValue> dummy;
+    return loadModule(nn_file_name, gpu_id).get_method("get_type_name")(dummy).toString()->string();
+}
+
+torch::jit::script::Module Network::loadModule(const std::string& nn_file_name, const int gpu_id)
+{
+    // keep the latest loaded module for each device, copies of a module share the same parameters
+    // loading another model replaces the entry, and the old parameters are freed when no network uses them
+    static std::mutex mutex;
+    static std::map<int, std::pair<std::string, torch::jit::script::Module>> modules;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = modules.find(gpu_id);
+    if (it != modules.end() && it->second.first == nn_file_name) { return it->second.second; }
+
+    torch::jit::script::Module module;
+    try {
+        module = torch::jit::load(nn_file_name, getDevice(gpu_id));
+        module.eval();
+        if (gpu_id == -1) {
+            setCPUThreads();
+            if (config::nn_cpu_optimize_for_inference) { module = optimizeForCPU(module); }
+        }
+    } catch (const c10::Error& e) {
+        std::cerr << e.msg() << std::endl;
+        assert(false);
+    }
+    modules[gpu_id] = {nn_file_name, module};
+    return module;
+}
+
+torch::jit::script::Module Network::optimizeForCPU(const torch::jit::script::Module& module)
+{
+    // freezing inlines the parameters as constants, other methods such as hyper-parameters and muzero inference must be preserved
+    std::vector<std::string> methods;
+    for (const auto& method : module.get_methods()) {
+        if (method.name() != "forward") { methods.push_back(method.name()); }
+    }
+    torch::jit::script::Module frozen_module = torch::jit::freeze(module, methods);
+    return torch::jit::optimize_for_inference(frozen_module, methods);
+}
+
+void Network::setCPUThreads()
+{
+    // the thread pools of libtorch can only be configured once, before they are used
+    static std::once_flag flag;
+    std::call_once(flag, []() {
+        if (config::nn_cpu_num_intra_op_threads > 0) { at::set_num_threads(config::nn_cpu_num_intra_op_threads); }
+        if (config::nn_cpu_num_inter_op_threads > 0) { at::set_num_interop_threads(config::nn_cpu_num_inter_op_threads); }
+    });
+}
+
+torch::Tensor Network::toInputTensor(const std::vector<torch::Tensor>& tensors) const
+{
+    return toInputTensor(torch::cat(tensors));
+}
+
+torch::Tensor Network::toInputTensor(const torch::Tensor& batch) const
+{
+    torch::Tensor input = batch.to(getDevice());
+    if (gpu_id_ == -1 && config::nn_cpu_channels_last) { input = input.contiguous(at::MemoryFormat::ChannelsLast); }
+    return input;
+}
+
 std::string Network::toString() const
 {
     std::ostringstream oss;
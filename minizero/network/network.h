@@ -20,6 +20,9 @@ public:
     virtual void loadModel(const std::string& nn_file_name, const int gpu_id);
     virtual std::string toString() const;
 
+    static std::string loadNetworkTypeName(const std::string& nn_file_name, const int gpu_id);
+    static torch::jit::script::Module loadModule(const std::string& nn_file_name, const int gpu_id);
+
     inline int getGPUID() const { return gpu_id_; }
     inline int getNumInputChannels() const { return num_input_channels_; }
     inline int getInputChannelHeight() const { return input_channel_height_; }
@@ -36,7 +39,12 @@ public:
     inline std::string getNetworkFileName() const { return network_file_name_; }
 
 protected:
-    inline torch::Device getDevice() const { return (gpu_id_ == -1 ? torch::Device("cpu") : torch::Device(torch::kCUDA, gpu_id_)); }
+    static torch::jit::script::Module optimizeForCPU(const torch::jit::script::Module& module);
+    static void setCPUThreads();
+    static inline torch::Device getDevice(const int gpu_id) { return (gpu_id == -1 ? torch::Device("cpu") : torch::Device(torch::kCUDA, gpu_id)); }
+    inline torch::Device getDevice() const { return getDevice(gpu_id_); }
+    torch::Tensor toInputTensor(const std::vector<torch::Tensor>& tensors) const;
+    torch::Tensor toInputTensor(const torch::Tensor& batch) const;
 
     int gpu_id_;
     int num_input_channels_;
@@ -0,0 +1,88 @@
+#include "network_benchmark.h"
+#include "create_network.h"
+#include "random.h"
+#include "time_system.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace minizero::network {
+
+using namespace minizero::utils;
+
+void NetworkBenchmark::run()
+{
+    std::cout << "model " << nn_file_name_ << " gpu_id " << gpu_id_ << std::endl;
+    runStartup(4);
+    for (int batch_size : {1, 8, 32, 128}) { runInference(batch_size, std::max(10, 512 / batch_size)); }
+}
+
+void NetworkBenchmark::runStartup(int num_networks)
+{
+    // only the first network loads the model, the others share its parameters
+    double start_rss = getResidentMemoryMB();
+    boost::posix_time::ptime start_ptime = TimeSystem::getLocalTime();
+    std::vector<std::shared_ptr<Network>> networks;
+    for (int i = 0; i < num_networks; ++i) {
+        networks.push_back(createNetwork(nn_file_name_, gpu_id_));
+        double seconds = (TimeSystem::getLocalTime() - start_ptime).total_microseconds() / 1e6;
+        std::cout << "networks " << std::setw(2) << networks.size()
+                  << " type " << networks.back()->getNetworkTypeName()
+                  << " startup time " << std::fixed << std::setprecision(3) << seconds << "s"
+                  << " rss " << std::setprecision(1) << getResidentMemoryMB() << "MB"
+                  << " (+" << getResidentMemoryMB() - start_rss << "MB)" << std::endl;
+    }
+}
+
+void NetworkBenchmark::runInference(int batch_size, int num_batches)
+{
+    // the inputs are random features, the first batch is for warming up and not counted
+    std::shared_ptr<Network> network = createNetwork(nn_file_name_, gpu_id_);
+    std::vector<float> features(network->getNumInputChannels() * network->getInputChannelHeight() * network->getInputChannelWidth());
+    for (auto& f : features) { f = Random::randReal(); }
+
+    boost::posix_time::ptime start_ptime;
+    for (int batch = 0; batch <= num_batches; ++batch) {
+        if (batch == 1) { start_ptime = TimeSystem::getLocalTime(); }
+        if (network->getNetworkTypeName() == "alphazero") {
+            std::shared_ptr<AlphaZeroNetwork> alphazero_network = std::static_pointer_cast<AlphaZeroNetwork>(network);
+            for (int i = 0; i < batch_size; ++i) { alphazero_network->pushBack(features); }
+            alphazero_network->forward();
+        } else {
+            std::shared_ptr<MuZeroNetwork> muzero_network = std::static_pointer_cast<MuZeroNetwork>(network);
+            for (int i = 0; i < batch_size; ++i) { muzero_network->pushBackInitialData(features); }
+            std::vector<std::shared_ptr<NetworkOutput>> outputs = muzero_network->initialInference();
+
+            // the recurrent inference reads the hidden states directly from the outputs of the initial inference, as the search does
+            std::vector<float> actions(muzero_network->getNumActionFeatureChannels() * muzero_network->getHiddenChannelHeight() * muzero_network->getHiddenChannelWidth(), 0.0f);
+            for (auto& output : outputs) { muzero_network->pushBackRecurrentData(std::static_pointer_cast<MuZeroNetworkOutput>(output)->hidden_state_, actions); }
+            muzero_network->recurrentInference();
+        }
+    }
+    double seconds = (TimeSystem::getLocalTime() - start_ptime).total_microseconds() / 1e6;
+
+    std::cout << "batch_size " << std::setw(4) << batch_size
+              << " latency " << std::fixed << std::setprecision(3) << seconds * 1000 / num_batches << "ms"
+              << " throughput " << std::setprecision(1) << batch_size * num_batches / seconds << " positions/s" << std::endl;
+}
+
+double NetworkBenchmark::getResidentMemoryMB() const
+{
+    std::ifstream fin("/proc/self/status");
+    std::string key;
+    double rss_kb = 0;
+    while (fin >> key) {
+        if (key == "VmRSS:") {
+            fin >> rss_kb;
+            break;
+        }
+        fin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    }
+    return rss_kb / 1024;
+}
+
+} // namespace minizero::network
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <string>
+
+namespace minizero::network {
+
+/*
+ * NetworkBenchmark measures the startup time and resident memory of creating several networks from one model file,
+ * and the latency and throughput of batched inference
+ */
+class NetworkBenchmark {
+public:
+    NetworkBenchmark(const std::string& nn_file_name, int gpu_id)
+        : nn_file_name_(nn_file_name),
+          gpu_id_(gpu_id)
+    {
+    }
+
+    void run();
+
+private:
+    void runStartup(int num_networks);
+    void runInference(int batch_size, int num_batches);
+    double getResidentMemoryMB() const;
+
+    std::string nn_file_name_;
+    int gpu_id_;
+};
+
+} // namespace minizero::network
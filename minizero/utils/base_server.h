@@ -1,9 +1,12 @@
 #pragma once
 
+#include "binary_frame.h"
 #include <boost/asio.hpp>
 #include <boost/bind.hpp>
 #include <boost/enable_shared_from_this.hpp>
 #include <boost/thread.hpp>
+#include <algorithm>
+#include <atomic>
 #include <queue>
 #include <string>
 #include <vector>
@@ -14,6 +17,8 @@ class ConnectionHandler : public boost::enable_shared_from_this<ConnectionHandle
 public:
     ConnectionHandler(boost::asio::io_service& io_service)
         : is_closed_(false),
+          is_read_paused_(false),
+          is_read_suspended_(false),
           socket_(io_service),
           strand_(io_service)
     {
@@ -29,30 +34,67 @@ public:
         strand_.dispatch(boost::bind(&ConnectionHandler::doWrite, shared_from_this(), message));
     }
 
-    void startRead()
+    void writeFrame(BinaryFrameHeader header, const std::string& payload)
     {
-        boost::asio::async_read_until(socket_,
-                                      read_buffer_, '\n',
-                                      boost::bind(&ConnectionHandler::handleRead,
-                                                  shared_from_this(),
-                                                  boost::asio::placeholders::error,
-                                                  boost::asio::placeholders::bytes_transferred));
+        if (isClosed()) { return; }
+        strand_.dispatch(boost::bind(&ConnectionHandler::doWrite, shared_from_this(), header.toFrame(payload)));
     }
 
+    void startRead() { strand_.dispatch(boost::bind(&ConnectionHandler::doRead, shared_from_this())); }
+
+    // stop reading after the current message until resumeRead() is called, must be called from a receive handler
+    void pauseRead() { is_read_paused_ = true; }
+    void resumeRead() { strand_.dispatch(boost::bind(&ConnectionHandler::doResumeRead, shared_from_this())); }
+
     virtual void close()
     {
-        if (is_closed_) { return; }
+        if (is_closed_.exchange(true)) { return; }
 
-        is_closed_ = true;
-        socket_.close();
+        // close the socket in the strand so that it never races with the read and write handlers
+        strand_.dispatch(boost::bind(&ConnectionHandler::doClose, shared_from_this()));
     }
 
     inline bool isClosed() const { return is_closed_; }
     inline boost::asio::ip::tcp::socket& getSocket() { return socket_; }
 
     virtual void handleReceivedMessage(const std::string& message) = 0;
+    virtual void handleReceivedFrame(const BinaryFrameHeader& header, std::string& payload) { close(); }
 
 private:
+    void doRead()
+    {
+        // peek the first byte to decide whether the next message is a text line or a binary frame
+        boost::asio::async_read(socket_,
+                                read_buffer_,
+                                boost::asio::transfer_exactly(read_buffer_.size() > 0 ? 0 : 1),
+                                strand_.wrap(boost::bind(&ConnectionHandler::handleReadFirstByte,
+                                                         shared_from_this(),
+                                                         boost::asio::placeholders::error)));
+    }
+
+    void doContinueRead()
+    {
+        if (is_read_paused_) {
+            is_read_suspended_ = true;
+            return;
+        }
+        doRead();
+    }
+
+    void doResumeRead()
+    {
+        is_read_paused_ = false;
+        if (!is_read_suspended_) { return; }
+        is_read_suspended_ = false;
+        doRead();
+    }
+
+    void doClose()
+    {
+        boost::system::error_code error;
+        socket_.close(error);
+    }
+
     void doWrite(const std::string& message)
     {
         message_queue_.push(message);
@@ -79,6 +121,31 @@ private:
         if (!message_queue_.empty()) { writeNext(); }
     }
 
+    void handleReadFirstByte(const boost::system::error_code& error)
+    {
+        if (error) {
+            close();
+            return;
+        }
+
+        if (static_cast<unsigned char>(*boost::asio::buffers_begin(read_buffer_.data())) == BinaryFrameHeader::kMagic) {
+            int remaining_size = std::max(0, BinaryFrameHeader::kSize - static_cast<int>(read_buffer_.size()));
+            boost::asio::async_read(socket_,
+                                    read_buffer_,
+                                    boost::asio::transfer_exactly(remaining_size),
+                                    strand_.wrap(boost::bind(&ConnectionHandler::handleReadFrameHeader,
+                                                             shared_from_this(),
+                                                             boost::asio::placeholders::error)));
+        } else {
+            boost::asio::async_read_until(socket_,
+                                          read_buffer_, '\n',
+                                          strand_.wrap(boost::bind(&ConnectionHandler::handleRead,
+                                                                   shared_from_this(),
+                                                                   boost::asio::placeholders::error,
+                                                                   boost::asio::placeholders::bytes_transferred)));
+        }
+    }
+
     void handleRead(const boost::system::error_code& error, size_t bytes_read)
     {
         if (error) {
@@ -90,20 +157,64 @@ private:
         std::string line;
         std::getline(is, line);
         handleReceivedMessage(line);
-        startRead();
+        doContinueRead();
+    }
+
+    void handleReadFrameHeader(const boost::system::error_code& error)
+    {
+        if (error) {
+            close();
+            return;
+        }
+
+        char header_buffer[BinaryFrameHeader::kSize];
+        boost::asio::buffer_copy(boost::asio::buffer(header_buffer), read_buffer_.data());
+        read_buffer_.consume(BinaryFrameHeader::kSize);
+        if (!read_frame_header_.decode(header_buffer)) {
+            close();
+            return;
+        }
+
+        // move the bytes already buffered, then read the rest of the payload into the string directly
+        size_t buffered_size = std::min<size_t>(read_buffer_.size(), read_frame_header_.payload_length_);
+        read_frame_payload_.resize(read_frame_header_.payload_length_);
+        boost::asio::buffer_copy(boost::asio::buffer(&read_frame_payload_[0], buffered_size), read_buffer_.data());
+        read_buffer_.consume(buffered_size);
+        boost::asio::async_read(socket_,
+                                boost::asio::buffer(&read_frame_payload_[0] + buffered_size, read_frame_payload_.size() - buffered_size),
+                                strand_.wrap(boost::bind(&ConnectionHandler::handleReadFramePayload,
+                                                         shared_from_this(),
+                                                         boost::asio::placeholders::error)));
+    }
+
+    void handleReadFramePayload(const boost::system::error_code& error)
+    {
+        if (error) {
+            close();
+            return;
+        }
+
+        std::string payload;
+        payload.swap(read_frame_payload_);
+        handleReceivedFrame(read_frame_header_, payload);
+        doContinueRead();
     }
 
-    bool is_closed_;
+    std::atomic<bool> is_closed_;
+    bool is_read_paused_;    // only accessed in the strand
+    bool is_read_suspended_; // a read is pending until the connection is resumed
     std::queue<std::string> message_queue_;
     boost::asio::ip::tcp::socket socket_;
     boost::asio::io_service::strand strand_;
     boost::asio::streambuf read_buffer_;
+    BinaryFrameHeader read_frame_header_;
+    std::string read_frame_payload_;
 };
 
 template <class _ConnectionHandler>
 class BaseServer {
 public:
-    BaseServer(int port)
+    BaseServer(int port, int num_threads = 1)
         : work_(io_service_),
           acceptor_(io_service_)
     {
@@ -113,8 +224,8 @@ public:
         acceptor_.bind(endpoint);
         acceptor_.listen();
 
-        const int num_threads = 1;
-        for (int i = 0; i < num_threads; ++i) {
+        // handlers of different connections run in parallel, while those of the same connection are serialized by its strand
+        for (int i = 0; i < std::max(1, num_threads); ++i) {
             thread_pool_.create_thread(boost::bind(&BaseServer::run, this));
         }
     }
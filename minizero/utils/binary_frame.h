@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace minizero::utils {
+
+/**
+ * header of a binary frame, which is followed by a raw payload of payload_length_ bytes
+ *
+ * a binary frame starts with kMagic, which never starts a text message, so that binary frames
+ * and newline-terminated text messages can be mixed on the same connection
+ * all fields are encoded in little endian:
+ *  [0] magic, [1] type, [2] flags, [3] reserved, [4-7] data length, [8-11] game length,
+ *  [12-15] return (IEEE-754 float), [16-19] payload length, [20-23] model iteration
+ */
+class BinaryFrameHeader {
+public:
+    static const unsigned char kMagic = 0xff;
+    static const int kSize = 24;
+    static const uint32_t kMaxPayloadLength = 1u << 30;
+
+    enum class Type : uint8_t {
+        kNone = 0,
+        kSelfPlay = 1
+    };
+
+    enum Flag : uint8_t {
+        kFlagTerminal = 1 << 0
+    };
+
+    BinaryFrameHeader() : type_(Type::kNone), flags_(0), data_length_(0), game_length_(0), return_(0.0f), payload_length_(0), model_iteration_(0) {}
+
+    void encode(char* buffer) const
+    {
+        uint32_t return_bits = 0;
+        std::memcpy(&return_bits, &return_, sizeof(return_bits));
+        buffer[0] = static_cast<char>(kMagic);
+        buffer[1] = static_cast<char>(type_);
+        buffer[2] = static_cast<char>(flags_);
+        buffer[3] = 0;
+        encodeUInt32(buffer + 4, data_length_);
+        encodeUInt32(buffer + 8, game_length_);
+        encodeUInt32(buffer + 12, return_bits);
+        encodeUInt32(buffer + 16, payload_length_);
+        encodeUInt32(buffer + 20, model_iteration_);
+    }
+
+    bool decode(const char* buffer)
+    {
+        if (static_cast<unsigned char>(buffer[0]) != kMagic) { return false; }
+        uint32_t return_bits = decodeUInt32(buffer + 12);
+        type_ = static_cast<Type>(buffer[1]);
+        flags_ = static_cast<uint8_t>(buffer[2]);
+        data_length_ = decodeUInt32(buffer + 4);
+        game_length_ = decodeUInt32(buffer + 8);
+        std::memcpy(&return_, &return_bits, sizeof(return_));
+        payload_length_ = decodeUInt32(buffer + 16);
+        model_iteration_ = decodeUInt32(buffer + 20);
+        return payload_length_ <= kMaxPayloadLength;
+    }
+
+    std::string toFrame(const std::string& payload)
+    {
+        payload_length_ = payload.size();
+        std::string frame(kSize, '\0');
+        encode(&frame[0]);
+        frame += payload;
+        return frame;
+    }
+
+    Type type_;
+    uint8_t flags_;
+    uint32_t data_length_;
+    uint32_t game_length_;
+    float return_;
+    uint32_t payload_length_;
+    uint32_t model_iteration_;
+
+private:
+    static void encodeUInt32(char* buffer, uint32_t value)
+    {
+        for (int i = 0; i < 4; ++i) { buffer[i] = static_cast<char>((value >> (i * 8)) & 0xff); }
+    }
+
+    static uint32_t decodeUInt32(const char* buffer)
+    {
+        uint32_t value = 0;
+        for (int i = 0; i < 4; ++i) { value |= static_cast<uint32_t>(static_cast<unsigned char>(buffer[i])) << (i * 8); }
+        return value;
+    }
+};
+
+} // namespace minizero::utils
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "utils.h"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace minizero::utils {
+
+/**
+ * search statistics of a move, i.e., the root search distribution, value, and reward, recorded in the action info
+ *
+ * the statistics are encoded as a base64 string of a little-endian binary record, which is shorter and much faster
+ * to parse than the "id:count,..." text of separate policy, value, and reward fields:
+ *  [0] flags, [1-2] number of entries, then each entry has an action id (uint16) and a count,
+ *  followed by the value and the reward (IEEE-754 float)
+ * counts are stored as uint16 when they are all small integers (visit counts), otherwise as IEEE-754 float
+ */
+class SearchStatistics {
+public:
+    enum Flag : uint8_t {
+        kFlagIntegerCount = 1 << 0
+    };
+
+    SearchStatistics() : value_(0.0f), reward_(0.0f) {}
+
+    std::string encode() const
+    {
+        assert(distribution_.size() <= UINT16_MAX);
+        bool is_integer_count = true;
+        for (const auto& p : distribution_) { is_integer_count &= (p.second >= 0 && p.second <= UINT16_MAX && std::floor(p.second) == p.second); }
+
+        const int count_size = (is_integer_count ? sizeof(uint16_t) : sizeof(float));
+        std::string binary(3 + distribution_.size() * (sizeof(uint16_t) + count_size) + 2 * sizeof(float), '\0');
+        char* buffer = &binary[0];
+        *buffer++ = static_cast<char>(is_integer_count ? kFlagIntegerCount : 0);
+        buffer = encodeUInt16(buffer, distribution_.size());
+        for (const auto& p : distribution_) {
+            assert(p.first >= 0 && p.first <= UINT16_MAX);
+            buffer = encodeUInt16(buffer, p.first);
+            buffer = (is_integer_count ? encodeUInt16(buffer, static_cast<uint16_t>(p.second)) : encodeFloat(buffer, p.second));
+        }
+        buffer = encodeFloat(buffer, value_);
+        buffer = encodeFloat(buffer, reward_);
+        return binaryToBase64String(binary);
+    }
+
+    bool decode(const std::string& s)
+    {
+        distribution_.clear();
+        if (s.size() % 4 != 0) { return false; }
+        const std::string binary = base64ToBinaryString(s);
+        if (binary.size() < 3) { return false; }
+        const char* buffer = binary.data();
+        const bool is_integer_count = (static_cast<uint8_t>(*buffer++) & kFlagIntegerCount);
+        const int num_entries = decodeUInt16(buffer);
+        buffer += sizeof(uint16_t);
+        const size_t count_size = (is_integer_count ? sizeof(uint16_t) : sizeof(float));
+        if (binary.size() != 3 + num_entries * (sizeof(uint16_t) + count_size) + 2 * sizeof(float)) { return false; }
+
+        distribution_.reserve(num_entries);
+        for (int i = 0; i < num_entries; ++i) {
+            int action_id = decodeUInt16(buffer);
+            float count = (is_integer_count ? decodeUInt16(buffer + sizeof(uint16_t)) : decodeFloat(buffer + sizeof(uint16_t)));
+            distribution_.emplace_back(action_id, count);
+            buffer += sizeof(uint16_t) + count_size;
+        }
+        value_ = decodeFloat(buffer);
+        reward_ = decodeFloat(buffer + sizeof(float));
+        return true;
+    }
+
+    std::vector<std::pair<int, float>> distribution_;
+    float value_;
+    float reward_;
+
+private:
+    static char* encodeUInt16(char* buffer, uint16_t value)
+    {
+        buffer[0] = static_cast<char>(value & 0xff);
+        buffer[1] = static_cast<char>((value >> 8) & 0xff);
+        return buffer + sizeof(uint16_t);
+    }
+
+    static char* encodeFloat(char* buffer, float value)
+    {
+        uint32_t bits = 0;
+        std::memcpy(&bits, &value, sizeof(bits));
+        for (size_t i = 0; i < sizeof(bits); ++i) { buffer[i] = static_cast<char>((bits >> (8 * i)) & 0xff); }
+        return buffer + sizeof(float);
+    }
+
+    static uint16_t decodeUInt16(const char* buffer)
+    {
+        return static_cast<uint16_t>(static_cast<unsigned char>(buffer[0]) | (static_cast<unsigned char>(buffer[1]) << 8));
+    }
+
+    static float decodeFloat(const char* buffer)
+    {
+        uint32_t bits = 0;
+        for (size_t i = 0; i < sizeof(bits); ++i) { bits |= static_cast<uint32_t>(static_cast<unsigned char>(buffer[i])) << (8 * i); }
+        float value = 0.0f;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+};
+
+} // namespace minizero::utils
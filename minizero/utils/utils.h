@@ -4,7 +4,9 @@
 #include <boost/iostreams/copy.hpp>
 #include <boost/iostreams/filter/gzip.hpp>
 #include <boost/iostreams/filtering_streambuf.hpp>
+#include <cassert>
 #include <cmath>
+#include <cstdint>
 #include <iomanip>
 #include <numeric>
 #include <sstream>
@@ -66,6 +68,48 @@ inline std::string hexToBinaryString(const std::string& s)
     return decompressed_string;
 }
 
+inline std::string binaryToBase64String(const std::string& s)
+{
+    // encode binary string to base64 string, which contains no special characters of sgf
+    static const char* kBase64Chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string encoded;
+    encoded.reserve((s.size() + 2) / 3 * 4);
+    for (size_t i = 0; i < s.size(); i += 3) {
+        uint32_t bits = static_cast<unsigned char>(s[i]) << 16;
+        if (i + 1 < s.size()) { bits |= static_cast<unsigned char>(s[i + 1]) << 8; }
+        if (i + 2 < s.size()) { bits |= static_cast<unsigned char>(s[i + 2]); }
+        encoded += kBase64Chars[(bits >> 18) & 0x3f];
+        encoded += kBase64Chars[(bits >> 12) & 0x3f];
+        encoded += (i + 1 < s.size() ? kBase64Chars[(bits >> 6) & 0x3f] : '=');
+        encoded += (i + 2 < s.size() ? kBase64Chars[bits & 0x3f] : '=');
+    }
+    return encoded;
+}
+
+inline std::string base64ToBinaryString(const std::string& s)
+{
+    assert(s.size() % 4 == 0);
+
+    // decode base64 string to binary string
+    auto decodeChar = [](char c) -> uint32_t {
+        if (c >= 'A' && c <= 'Z') { return c - 'A'; }
+        if (c >= 'a' && c <= 'z') { return c - 'a' + 26; }
+        if (c >= '0' && c <= '9') { return c - '0' + 52; }
+        return (c == '+' ? 62 : 63);
+    };
+    std::string decoded;
+    decoded.reserve(s.size() / 4 * 3);
+    for (size_t i = 0; i + 3 < s.size(); i += 4) {
+        uint32_t bits = (decodeChar(s[i]) << 18) | (decodeChar(s[i + 1]) << 12);
+        if (s[i + 2] != '=') { bits |= decodeChar(s[i + 2]) << 6; }
+        if (s[i + 3] != '=') { bits |= decodeChar(s[i + 3]); }
+        decoded += static_cast<char>((bits >> 16) & 0xff);
+        if (s[i + 2] != '=') { decoded += static_cast<char>((bits >> 8) & 0xff); }
+        if (s[i + 3] != '=') { decoded += static_cast<char>(bits & 0xff); }
+    }
+    return decoded;
+}
+
 inline std::string decompressBinaryString(const std::string& s)
 {
     if (s.empty()) { return s; }
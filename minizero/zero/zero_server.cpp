@@ -4,9 +4,15 @@
 #include "utils.h"
 #include <algorithm>
 #include <boost/algorithm/string.hpp>
+#include <boost/iostreams/device/file.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#include <fcntl.h>
+#include <cstdlib>
 #include <iostream>
 #include <limits>
 #include <string>
+#include <unistd.h>
+#include <utility>
 #include <vector>
 
 namespace minizero::zero {
@@ -32,36 +38,145 @@ void ZeroLogger::createLog()
 
 void ZeroLogger::addLog(const std::string& log_str, std::fstream& log_file)
 {
+    boost::lock_guard<boost::mutex> lock(mutex_);
     log_file << TimeSystem::getTimeString("[Y/m/d_H:i:s.f] ") << log_str << std::endl;
     std::cerr << TimeSystem::getTimeString("[Y/m/d_H:i:s.f] ") << log_str << std::endl;
 }
 
-ZeroSelfPlayData::ZeroSelfPlayData(std::string input_data)
+void ZeroSelfPlayWriter::open(const std::string& file_name)
+{
+    assert(!writer_thread_.joinable());
+
+    // records are written through a large buffer, optionally compressed as a gzip stream
+    file_name_ = file_name + (config::zero_server_compress_self_play_games ? ".gz" : "");
+    if (config::zero_server_compress_self_play_games) { out_.push(boost::iostreams::gzip_compressor()); }
+    out_.push(boost::iostreams::file_sink(file_name_, std::ios::out | std::ios::binary), kSelfPlayWriterBufferSize);
+    is_closing_ = false;
+    writer_thread_ = boost::thread(&ZeroSelfPlayWriter::runWriter, this);
+}
+
+void ZeroSelfPlayWriter::write(std::string& record)
+{
+    // wait if the writer falls behind, so that the memory of queued records is bounded
+    boost::unique_lock<boost::mutex> lock(mutex_);
+    const size_t max_queue_size = static_cast<size_t>(std::max(1, config::zero_server_self_play_writer_queue_size)) << 20;
+    cv_.wait(lock, [this, max_queue_size] { return queue_size_ < max_queue_size; });
+    queue_size_ += record.size();
+    record_queue_.emplace_back(std::move(record));
+    cv_.notify_all();
+}
+
+void ZeroSelfPlayWriter::close()
+{
+    if (!writer_thread_.joinable()) { return; }
+
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        is_closing_ = true;
+        cv_.notify_all();
+    }
+    writer_thread_.join();
+
+    // flush all records to disk at the end of each iteration
+    boost::iostreams::close(out_);
+    out_.reset();
+    int fd = ::open(file_name_.c_str(), O_RDONLY);
+    if (fd != -1) {
+        ::fsync(fd);
+        ::close(fd);
+    }
+}
+
+void ZeroSelfPlayWriter::runWriter()
+{
+    std::deque<std::string> records;
+    while (true) {
+        {
+            boost::unique_lock<boost::mutex> lock(mutex_);
+            cv_.wait(lock, [this] { return !record_queue_.empty() || is_closing_; });
+            if (record_queue_.empty()) { break; }
+            records.swap(record_queue_);
+        }
+
+        // the queued size is only released after the records are written, since they are still held in memory until then
+        size_t written_size = 0;
+        for (const auto& record : records) {
+            out_.write(record.data(), record.size());
+            written_size += record.size();
+        }
+        records.clear();
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        queue_size_ -= written_size;
+        cv_.notify_all();
+    }
+}
+
+ZeroSelfPlayData::ZeroSelfPlayData(const std::string& input_data)
 {
     // format: Selfplay is_terminal data_length game_length return game_record
-    input_data = input_data.substr(input_data.find(" ") + 1); // remove Selfplay
-    is_terminal_ = (input_data.substr(0, input_data.find(" ")) == "true");
-    input_data = input_data.substr(input_data.find(" ") + 1); // remove is_terminal
-    data_length_ = std::stoi(input_data.substr(0, input_data.find(" ")));
-    input_data = input_data.substr(input_data.find(" ") + 1); // remove data_length
-    game_length_ = std::stoi(input_data.substr(0, input_data.find(" ")));
-    input_data = input_data.substr(input_data.find(" ") + 1); // remove game_length
-    return_ = std::stof(input_data.substr(0, input_data.find(" ")));
-    input_data = input_data.substr(input_data.find(" ") + 1); // remove return
-    game_record_ = input_data.substr(0, input_data.find(" "));
+    // fields are parsed in place, only the game record is copied
+    size_t begin = input_data.find(" ") + 1; // skip Selfplay
+    size_t end = input_data.find(" ", begin);
+    is_terminal_ = (input_data.compare(begin, end - begin, "true") == 0);
+    char* field_end = nullptr;
+    data_length_ = std::strtol(input_data.c_str() + end, &field_end, 10);
+    game_length_ = std::strtol(field_end, &field_end, 10);
+    return_ = std::strtof(field_end, &field_end);
+    begin = field_end - input_data.c_str() + 1;
+    game_record_.assign(input_data, begin, input_data.find(" ", begin) - begin);
+
+    // the model iteration is only recorded in the EV tag of text messages
+    size_t model_pos = game_record_.find("weight_iter_");
+    model_iteration_ = (model_pos == std::string::npos ? 0 : std::atoi(game_record_.c_str() + model_pos + std::string("weight_iter_").size()));
 }
 
-bool ZeroWorkerSharedData::getSelfPlayData(ZeroSelfPlayData& sp_data)
+ZeroSelfPlayData::ZeroSelfPlayData(const utils::BinaryFrameHeader& header, std::string& payload)
+    : is_terminal_(header.flags_ & utils::BinaryFrameHeader::kFlagTerminal),
+      data_length_(header.data_length_),
+      game_length_(header.game_length_),
+      return_(header.return_),
+      model_iteration_(header.model_iteration_)
 {
-    if (sp_data_queue_.empty()) { return false; }
+    // the payload is the game record itself, take it over without copying
+    game_record_.swap(payload);
+}
 
-    boost::lock_guard<boost::mutex> lock(mutex_);
+bool ZeroWorkerSharedData::waitSelfPlayData(ZeroSelfPlayData& sp_data)
+{
+    // block until a game arrives, or return false when workers are updated and may need new jobs
+    boost::unique_lock<boost::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return !sp_data_queue_.empty() || is_worker_updated_; });
+    is_worker_updated_ = false;
     if (sp_data_queue_.empty()) { return false; }
-    sp_data = sp_data_queue_.front();
+    sp_data = std::move(sp_data_queue_.front());
     sp_data_queue_.pop();
+    sp_data_queue_size_ -= sp_data.game_record_.size();
+
+    // resume the paused workers once the queue is drained below half of its bound
+    const size_t max_queue_size = static_cast<size_t>(std::max(1, config::zero_server_self_play_data_queue_size)) << 20;
+    if (sp_data_queue_size_ <= max_queue_size / 2 && !paused_workers_.empty()) {
+        for (auto& worker : paused_workers_) { worker->resumeRead(); }
+        paused_workers_.clear();
+    }
     return true;
 }
 
+bool ZeroWorkerSharedData::waitOptimizationDone()
+{
+    // block until the optimization finishes, or return false when workers are updated and may need new jobs
+    boost::unique_lock<boost::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return !is_optimization_phase_ || is_worker_updated_; });
+    is_worker_updated_ = false;
+    return !is_optimization_phase_;
+}
+
+void ZeroWorkerSharedData::notifyWorkerUpdated()
+{
+    boost::lock_guard<boost::mutex> lock(mutex_);
+    is_worker_updated_ = true;
+    cv_.notify_all();
+}
+
 bool ZeroWorkerSharedData::isOptimizationPahse()
 {
     boost::lock_guard<boost::mutex> lock(mutex_);
@@ -80,9 +195,9 @@ void ZeroWorkerHandler::handleReceivedMessage(const std::string& message)
     boost::split(args, message, boost::is_any_of(" "), boost::token_compress_on);
 
     if (args[0] == "Info") {
+        boost::lock_guard<boost::mutex> lock(shared_data_.worker_mutex_);
         name_ = args[1];
         type_ = args[2];
-        boost::lock_guard<boost::mutex> lock(shared_data_.worker_mutex_);
         shared_data_.logger_.addWorkerLog("[Worker Connection] " + getName() + " " + getType());
         if (type_ == "sp") {
             std::string job_command = "";
@@ -107,6 +222,7 @@ void ZeroWorkerHandler::handleReceivedMessage(const std::string& message)
             ConnectionHandler::close();
         }
         is_idle_ = true;
+        shared_data_.notifyWorkerUpdated();
     } else if (args[0] == "SelfPlay") {
         if (message.find("SelfPlay", message.find("SelfPlay", 0) + 1) != std::string::npos || message.back() != '#') {
             shared_data_.logger_.addWorkerLog("[Worker Error] Receive broken self-play games");
@@ -114,17 +230,13 @@ void ZeroWorkerHandler::handleReceivedMessage(const std::string& message)
         }
 
         ZeroSelfPlayData sp_data(message); // create data before lock for efficiency
-        boost::lock_guard<boost::mutex> lock(shared_data_.mutex_);
-        shared_data_.sp_data_queue_.push(sp_data);
-
-        // print number of games if the queue already received many games in buffer
-        if (shared_data_.sp_data_queue_.size() % std::max(1, static_cast<int>(config::zero_num_games_per_iteration * 0.25)) == 0) {
-            shared_data_.logger_.addTrainingLog("[SelfPlay Game Buffer] " + std::to_string(shared_data_.sp_data_queue_.size()) + " games");
-        }
+        addSelfPlayData(sp_data);
     } else if (args[0] == "Optimization_Done") {
         boost::lock_guard<boost::mutex> lock(shared_data_.mutex_);
         shared_data_.model_iteration_ = stoi(args[1]);
         shared_data_.is_optimization_phase_ = false;
+        shared_data_.is_worker_updated_ = true; // self-play workers may load the new model
+        shared_data_.cv_.notify_all();
     } else if (args[0] == "Log") {
         shared_data_.logger_.addWorkerLog("[Log] " + getName() + " " + getType() + ": " + message.substr(message.find(" ") + 1));
     } else {
@@ -140,6 +252,18 @@ void ZeroWorkerHandler::handleReceivedMessage(const std::string& message)
     }
 }
 
+void ZeroWorkerHandler::handleReceivedFrame(const utils::BinaryFrameHeader& header, std::string& payload)
+{
+    if (header.type_ != utils::BinaryFrameHeader::Type::kSelfPlay || payload.empty()) {
+        shared_data_.logger_.addWorkerLog("[Worker Error] Receive broken binary frame");
+        close();
+        return;
+    }
+
+    ZeroSelfPlayData sp_data(header, payload);
+    addSelfPlayData(sp_data);
+}
+
 void ZeroWorkerHandler::close()
 {
     if (isClosed()) { return; }
@@ -150,6 +274,27 @@ void ZeroWorkerHandler::close()
     if (getType() == "op") { --shared_data_.num_op_worker_; }
 }
 
+void ZeroWorkerHandler::addSelfPlayData(ZeroSelfPlayData& sp_data)
+{
+    boost::lock_guard<boost::mutex> lock(shared_data_.mutex_);
+    shared_data_.sp_data_queue_size_ += sp_data.game_record_.size();
+    shared_data_.sp_data_queue_.push(std::move(sp_data));
+    shared_data_.cv_.notify_all();
+
+    // apply backpressure instead of blocking the io thread: stop reading from this worker until the queue is drained,
+    // so that the unread games stay in the socket buffers of the workers
+    const size_t max_queue_size = static_cast<size_t>(std::max(1, config::zero_server_self_play_data_queue_size)) << 20;
+    if (shared_data_.sp_data_queue_size_ > max_queue_size) {
+        pauseRead();
+        shared_data_.paused_workers_.push_back(shared_from_this());
+    }
+
+    // print number of games if the queue already received many games in buffer
+    if (shared_data_.sp_data_queue_.size() % std::max(1, static_cast<int>(config::zero_num_games_per_iteration * 0.25)) == 0) {
+        shared_data_.logger_.addTrainingLog("[SelfPlay Game Buffer] " + std::to_string(shared_data_.sp_data_queue_.size()) + " games");
+    }
+}
+
 void ZeroWorkerHandler::syncConfig()
 {
     if (shared_data_.updated_conf_str_.empty()) { return; }
@@ -162,15 +307,23 @@ void ZeroServer::run()
     startAccept();
     std::cerr << TimeSystem::getTimeString("[Y/m/d_H:i:s.f] ") << "Server initialize over." << std::endl;
 
-    for (iteration_ = config::zero_start_iteration; iteration_ <= config::zero_end_iteration; ++iteration_) {
-        syncConfig();
-        selfPlay();
-        optimization();
-    }
+    for (iteration_ = config::zero_start_iteration; iteration_ <= config::zero_end_iteration; ++iteration_) { runIteration(); }
+    finishOptimization();
 
     close();
 }
 
+void ZeroServer::runIteration()
+{
+    syncConfig();
+    selfPlay();
+
+    // in asynchronous training, the previous optimization runs while collecting games, and the new one keeps running during the next self-play
+    finishOptimization();
+    startOptimization();
+    if (!config::zero_server_async_training) { finishOptimization(); }
+}
+
 void ZeroServer::initialize()
 {
     int seed = config::program_auto_seed ? static_cast<int>(time(NULL)) : config::program_seed;
@@ -183,34 +336,42 @@ void ZeroServer::initialize()
     shared_data_.num_op_worker_ = 0;
     shared_data_.model_iteration_ = stoi(nn_file_name);
     shared_data_.updated_conf_str_ = getUpdatedConfig();
+    published_model_iterations_ = {shared_data_.model_iteration_};
 }
 
 void ZeroServer::selfPlay()
 {
     // setup
     std::string self_play_file_name = config::zero_training_directory + "/sgf/" + std::to_string(iteration_) + ".sgf";
-    if (config::zero_num_games_per_iteration > 0) { shared_data_.logger_.getSelfPlayFileStream().open(self_play_file_name.c_str(), std::ios::out); }
+    if (config::zero_num_games_per_iteration > 0) { self_play_writer_.open(self_play_file_name); }
     shared_data_.logger_.addTrainingLog("[Iteration] =====" + std::to_string(iteration_) + "=====");
     shared_data_.logger_.addTrainingLog("[SelfPlay] Start " + std::to_string(shared_data_.getModelIetration()));
 
     std::vector<int> game_lengths;
     std::vector<float> game_returns;
     int num_collect_game = 0, total_data_length = 0;
+    int num_stale_game = 0, total_model_staleness = 0;
     while (num_collect_game < config::zero_num_games_per_iteration) {
         broadcastSelfPlayJob();
+        broadcastOptimizationJob();
 
         // read one selfplay game
         ZeroSelfPlayData sp_data;
-        if (!shared_data_.getSelfPlayData(sp_data)) {
-            boost::this_thread::sleep(boost::posix_time::milliseconds(100));
+        if (!shared_data_.waitSelfPlayData(sp_data)) {
             continue;
-        } else if (!config::zero_server_accept_different_model_games && sp_data.game_record_.find("weight_iter_" + std::to_string(shared_data_.getModelIetration())) == std::string::npos) {
+        } else if (config::zero_server_async_training && getModelStaleness(sp_data.model_iteration_) > config::zero_server_max_model_staleness) {
+            // discard self-play games generated by models that are too old
+            ++num_stale_game;
+            continue;
+        } else if (!config::zero_server_async_training && !config::zero_server_accept_different_model_games && sp_data.game_record_.find("weight_iter_" + std::to_string(shared_data_.getModelIetration())) == std::string::npos) {
             // discard previous self-play games
             continue;
         }
+        total_model_staleness += getModelStaleness(sp_data.model_iteration_);
 
         // save record
-        shared_data_.logger_.getSelfPlayFileStream() << sp_data.game_record_ << (sp_data.is_terminal_ ? " #" : "") << std::endl;
+        sp_data.game_record_ += (sp_data.is_terminal_ ? " #\n" : "\n");
+        self_play_writer_.write(sp_data.game_record_);
         ++num_collect_game;
         total_data_length += sp_data.data_length_;
         if (sp_data.is_terminal_) {
@@ -234,9 +395,13 @@ void ZeroServer::selfPlay()
         }
     }
 
-    stopJob("sp");
-    if (config::zero_num_games_per_iteration > 0) { shared_data_.logger_.getSelfPlayFileStream().close(); }
+    if (!config::zero_server_async_training) { stopJob("sp"); }
+    if (config::zero_num_games_per_iteration > 0) { self_play_writer_.close(); }
     shared_data_.logger_.addTrainingLog("[SelfPlay] Finished.");
+    if (config::zero_server_async_training && num_collect_game > 0) {
+        shared_data_.logger_.addTrainingLog("[SelfPlay Avg. Model Staleness] " + std::to_string(total_model_staleness * 1.0f / num_collect_game));
+        shared_data_.logger_.addTrainingLog("[SelfPlay # Discarded Stale Games] " + std::to_string(num_stale_game));
+    }
     if (!game_lengths.empty()) {
         shared_data_.logger_.addTrainingLog("[SelfPlay # Finished Games] " + std::to_string(game_lengths.size()));
         shared_data_.logger_.addTrainingLog("[SelfPlay Min. Game Lengths] " + std::to_string(*std::min_element(game_lengths.begin(), game_lengths.end())));
@@ -265,39 +430,72 @@ void ZeroServer::selfPlay()
 
 void ZeroServer::broadcastSelfPlayJob()
 {
+    int model_iteration = shared_data_.getModelIetration();
+    bool is_new_model = (model_iteration != published_model_iterations_.back());
+    if (is_new_model) { published_model_iterations_.push_back(model_iteration); }
+
+    std::string load_model_command = "load_model " + config::zero_training_directory + "/model/weight_iter_" + std::to_string(model_iteration) + ".pt";
     boost::lock_guard<boost::mutex> lock(worker_mutex_);
     for (auto& worker : connections_) {
-        if (!worker->isIdle() || worker->getType() != "sp") { continue; }
-        worker->setIdle(false);
-        worker->write("load_model " + config::zero_training_directory + "/model/weight_iter_" + std::to_string(shared_data_.getModelIetration()) + ".pt");
-        worker->write("reset_actors");
-        worker->write("start");
+        if (worker->getType() != "sp") { continue; }
+        if (worker->isIdle()) {
+            worker->setIdle(false);
+            worker->write(load_model_command);
+            worker->write("reset_actors");
+            worker->write("start");
+        } else if (is_new_model && config::zero_server_async_training) {
+            // running workers switch to the latest model without stopping
+            worker->write(load_model_command);
+        }
     }
 }
 
-void ZeroServer::optimization()
+void ZeroServer::startOptimization()
 {
     shared_data_.logger_.addTrainingLog("[Optimization] Start.");
 
-    std::string job_command = "train ";
-    job_command += "weight_iter_" + std::to_string(shared_data_.getModelIetration()) + ".pkl";
-    job_command += " " + std::to_string(std::max(1, iteration_ - config::zero_replay_buffer + 1));
-    job_command += " " + std::to_string(iteration_);
+    optimization_job_command_ = "train ";
+    optimization_job_command_ += "weight_iter_" + std::to_string(shared_data_.getModelIetration()) + ".pkl";
+    optimization_job_command_ += " " + std::to_string(std::max(1, iteration_ - config::zero_replay_buffer + 1));
+    optimization_job_command_ += " " + std::to_string(iteration_);
 
-    shared_data_.is_optimization_phase_ = true;
-    while (shared_data_.isOptimizationPahse()) {
-        boost::lock_guard<boost::mutex> lock(worker_mutex_);
-        for (auto worker : connections_) {
-            if (!worker->isIdle() || worker->getType() != "op") { continue; }
-            worker->setIdle(false);
-            worker->write(job_command);
-        }
+    {
+        boost::lock_guard<boost::mutex> lock(shared_data_.mutex_);
+        shared_data_.is_optimization_phase_ = true;
     }
+    is_optimizing_ = true;
+    broadcastOptimizationJob();
+}
+
+void ZeroServer::broadcastOptimizationJob()
+{
+    if (!shared_data_.isOptimizationPahse()) { return; }
+
+    boost::lock_guard<boost::mutex> lock(worker_mutex_);
+    for (auto worker : connections_) {
+        if (!worker->isIdle() || worker->getType() != "op") { continue; }
+        worker->setIdle(false);
+        worker->write(optimization_job_command_);
+    }
+}
+
+void ZeroServer::finishOptimization()
+{
+    if (!is_optimizing_) { return; }
+
+    while (!shared_data_.waitOptimizationDone()) { broadcastOptimizationJob(); }
     stopJob("op");
+    is_optimizing_ = false;
 
     shared_data_.logger_.addTrainingLog("[Optimization] Finished.");
 }
 
+int ZeroServer::getModelStaleness(int model_iteration) const
+{
+    // the number of models published after the given one
+    return std::count_if(published_model_iterations_.begin(), published_model_iterations_.end(), [model_iteration](int iteration) { return iteration > model_iteration; });
+}
+
 std::string ZeroServer::getUpdatedConfig()
 {
     std::string job_command = "";
@@ -4,8 +4,10 @@
 #include "configuration.h"
 #include "time_system.h"
 #include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
 #include <boost/thread.hpp>
 #include <ctime>
+#include <deque>
 #include <fstream>
 #include <queue>
 #include <string>
@@ -13,6 +15,8 @@
 
 namespace minizero::zero {
 
+const int kSelfPlayWriterBufferSize = 1 << 20;
+
 class ZeroLogger {
 public:
     ZeroLogger() {}
@@ -20,14 +24,36 @@ public:
 
     inline void addWorkerLog(const std::string& log_str) { addLog(log_str, worker_log_); }
     inline void addTrainingLog(const std::string& log_str) { addLog(log_str, training_log_); }
-    inline std::fstream& getSelfPlayFileStream() { return self_play_game_; }
 
 private:
     void addLog(const std::string& log_str, std::fstream& log_file);
 
+    boost::mutex mutex_;
     std::fstream worker_log_;
     std::fstream training_log_;
-    std::fstream self_play_game_;
+};
+
+class ZeroSelfPlayWriter {
+public:
+    ZeroSelfPlayWriter() : is_closing_(false), queue_size_(0) {}
+
+    void open(const std::string& file_name);
+    void write(std::string& record);
+    void close();
+
+    inline const std::string& getFileName() const { return file_name_; }
+
+private:
+    void runWriter();
+
+    bool is_closing_;
+    size_t queue_size_;
+    std::string file_name_;
+    std::deque<std::string> record_queue_;
+    boost::iostreams::filtering_ostream out_;
+    boost::thread writer_thread_;
+    boost::mutex mutex_;
+    boost::condition_variable cv_;
 };
 
 class ZeroSelfPlayData {
@@ -36,31 +62,42 @@ public:
     int data_length_;
     int game_length_;
     float return_;
+    int model_iteration_;
     std::string game_record_;
 
     ZeroSelfPlayData() {}
-    ZeroSelfPlayData(std::string input_data);
+    ZeroSelfPlayData(const std::string& input_data);
+    ZeroSelfPlayData(const utils::BinaryFrameHeader& header, std::string& payload);
 };
 
 class ZeroWorkerSharedData {
 public:
     ZeroWorkerSharedData(boost::mutex& worker_mutex)
-        : worker_mutex_(worker_mutex)
+        : is_optimization_phase_(false),
+          is_worker_updated_(false),
+          sp_data_queue_size_(0),
+          worker_mutex_(worker_mutex)
     {
     }
 
-    bool getSelfPlayData(ZeroSelfPlayData& sp_data);
+    bool waitSelfPlayData(ZeroSelfPlayData& sp_data);
+    bool waitOptimizationDone();
+    void notifyWorkerUpdated();
     bool isOptimizationPahse();
     int getModelIetration();
 
     bool is_optimization_phase_;
+    bool is_worker_updated_;
     int num_op_worker_;
     int total_games_;
     int model_iteration_;
     ZeroLogger logger_;
     std::string updated_conf_str_;
     std::queue<ZeroSelfPlayData> sp_data_queue_;
+    size_t sp_data_queue_size_;                                               // total size of game records in sp_data_queue_
+    std::vector<boost::shared_ptr<utils::ConnectionHandler>> paused_workers_; // workers that stop reading until the queue is drained
     boost::mutex mutex_;
+    boost::condition_variable cv_; // notified with mutex_ when self-play data arrives, optimization finishes, or workers become idle
     boost::mutex& worker_mutex_;
 };
 
@@ -74,6 +111,7 @@ public:
     }
 
     void handleReceivedMessage(const std::string& message) override;
+    void handleReceivedFrame(const utils::BinaryFrameHeader& header, std::string& payload) override;
     void close() override;
     void syncConfig();
 
@@ -83,6 +121,8 @@ public:
     inline void setIdle(bool is_idle) { is_idle_ = is_idle; }
 
 private:
+    void addSelfPlayData(ZeroSelfPlayData& sp_data);
+
     bool is_idle_;
     std::string name_;
     std::string type_;
@@ -92,7 +132,8 @@ private:
 class ZeroServer : public utils::BaseServer<ZeroWorkerHandler> {
 public:
     ZeroServer()
-        : BaseServer(minizero::config::zero_server_port),
+        : BaseServer(minizero::config::zero_server_port, minizero::config::zero_server_num_io_threads),
+          is_optimizing_(false),
           shared_data_(worker_mutex_),
           keep_alive_timer_(io_service_)
     {
@@ -100,6 +141,7 @@ public:
     }
 
     virtual void run();
+    virtual void runIteration();
     boost::shared_ptr<ZeroWorkerHandler> handleAcceptNewConnection() override { return boost::make_shared<ZeroWorkerHandler>(io_service_, shared_data_); }
     void sendInitialMessage(boost::shared_ptr<ZeroWorkerHandler> connection) override {}
 
@@ -107,7 +149,10 @@ protected:
     virtual void initialize();
     virtual void selfPlay();
     virtual void broadcastSelfPlayJob();
-    virtual void optimization();
+    virtual void startOptimization();
+    virtual void broadcastOptimizationJob();
+    virtual void finishOptimization();
+    int getModelStaleness(int model_iteration) const;
     virtual std::string getUpdatedConfig();
     void syncConfig();
     void stopJob(const std::string& job_type);
@@ -116,7 +161,11 @@ protected:
     void startKeepAlive();
 
     int iteration_;
+    bool is_optimizing_;
+    std::string optimization_job_command_;
+    std::vector<int> published_model_iterations_;
     ZeroWorkerSharedData shared_data_;
+    ZeroSelfPlayWriter self_play_writer_;
     boost::asio::deadline_timer keep_alive_timer_;
 
     std::vector<int> latest_game_lengths_;
@@ -0,0 +1,248 @@
+#include "zero_server_benchmark.h"
+#include "configuration.h"
+#include "time_system.h"
+#include <boost/thread.hpp>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace minizero::zero {
+
+using namespace minizero::utils;
+
+void BenchmarkWorkerHandler::handleReceivedMessage(const std::string& message)
+{
+    ZeroSelfPlayData sp_data(message);
+    shared_data_.num_bytes_ += message.size() + 1;
+    ++shared_data_.num_games_;
+}
+
+void BenchmarkWorkerHandler::handleReceivedFrame(const utils::BinaryFrameHeader& header, std::string& payload)
+{
+    shared_data_.num_bytes_ += BinaryFrameHeader::kSize + payload.size();
+    ZeroSelfPlayData sp_data(header, payload);
+    ++shared_data_.num_games_;
+}
+
+void BenchmarkZeroServer::runIterations(int num_iterations)
+{
+    // self-play games are written to [zero_training_directory]/sgf/, so use a temporary directory that is removed afterwards
+    std::string training_directory = (std::filesystem::temp_directory_path() / "zero_server_benchmark_XXXXXX").string();
+    if (!mkdtemp(&training_directory[0])) {
+        std::cerr << "[BenchmarkZeroServer] failed to create a temporary directory in " << std::filesystem::temp_directory_path() << std::endl;
+        exit(-1);
+    }
+    std::filesystem::create_directory(training_directory + "/sgf");
+    const std::string original_training_directory = config::zero_training_directory;
+    config::zero_training_directory = training_directory;
+
+    shared_data_.num_op_worker_ = 0;
+    shared_data_.model_iteration_ = 0;
+    published_model_iterations_ = {0};
+    for (iteration_ = 1; iteration_ <= num_iterations; ++iteration_) { runIteration(); }
+    finishOptimization();
+
+    config::zero_training_directory = original_training_directory;
+    std::filesystem::remove_all(training_directory);
+}
+
+bool ZeroServerBenchmark::run()
+{
+    // framing throughput with a few workers
+    const int num_workers = 4;
+    for (int record_size : {1 << 10, 1 << 16, 1 << 20}) {
+        int num_games_per_worker = std::max(16, (1 << 28) / record_size / num_workers);
+        runFraming(false, 1, num_workers, num_games_per_worker, record_size);
+        runFraming(true, 1, num_workers, num_games_per_worker, record_size);
+    }
+
+    // stress with many workers, comparing a single io thread with the configured io threads
+    const int num_stress_workers = 256;
+    for (int num_io_threads : {1, config::zero_server_num_io_threads}) {
+        runFraming(false, num_io_threads, num_stress_workers, 64, 1 << 16);
+        runFraming(true, num_io_threads, num_stress_workers, 64, 1 << 16);
+    }
+
+    bool is_idle = runIdle(2000);
+
+    // fake trainer and self-play worker on cpu, comparing synchronous and asynchronous training
+    runTraining(false, 5, 500);
+    runTraining(true, 5, 500);
+    return is_idle;
+}
+
+void ZeroServerBenchmark::runFraming(bool use_binary_frame, int num_io_threads, int num_workers, int num_games_per_worker, int record_size)
+{
+    BenchmarkServer server(config::zero_server_port, num_io_threads);
+    server.startAccept();
+
+    // workers send the same synthetic game record as fast as possible
+    const std::string message = getSelfPlayMessage(use_binary_frame, "(;" + std::string(record_size, 'x') + ")");
+    boost::posix_time::ptime start_ptime = TimeSystem::getLocalTime();
+    boost::thread_group workers;
+    for (int i = 0; i < num_workers; ++i) {
+        workers.create_thread([&message, num_games_per_worker]() {
+            boost::asio::io_service io_service;
+            boost::asio::ip::tcp::socket socket(io_service);
+            socket.connect(boost::asio::ip::tcp::endpoint(boost::asio::ip::address_v4::loopback(), config::zero_server_port));
+            for (int j = 0; j < num_games_per_worker; ++j) { boost::asio::write(socket, boost::asio::buffer(message)); }
+            socket.shutdown(boost::asio::ip::tcp::socket::shutdown_send);
+        });
+    }
+    workers.join_all();
+    while (server.shared_data_.num_games_ < num_workers * num_games_per_worker) { boost::this_thread::sleep(boost::posix_time::milliseconds(1)); }
+    double seconds = (TimeSystem::getLocalTime() - start_ptime).total_microseconds() / 1e6;
+    server.stop();
+
+    std::cout << (use_binary_frame ? "binary" : "text  ")
+              << " io_threads " << std::setw(2) << num_io_threads
+              << " workers " << std::setw(3) << num_workers
+              << " record_size " << std::setw(8) << record_size
+              << " games " << std::setw(7) << server.shared_data_.num_games_
+              << std::fixed << std::setprecision(1)
+              << " games/s " << std::setw(10) << server.shared_data_.num_games_ / seconds
+              << " MB/s " << std::setw(8) << server.shared_data_.num_bytes_ / seconds / (1 << 20) << std::endl;
+}
+
+bool ZeroServerBenchmark::runIdle(int idle_milliseconds)
+{
+    BenchmarkZeroServer server;
+    server.startAccept();
+
+    // fake workers stay idle after receiving their jobs before sending the results, during which the server should sleep
+    auto fake_worker = [idle_milliseconds](const std::string& type, const std::string& job_command, const std::string& result, int num_results) {
+        boost::asio::io_service io_service;
+        boost::asio::ip::tcp::socket socket(io_service);
+        socket.connect(boost::asio::ip::tcp::endpoint(boost::asio::ip::address_v4::loopback(), config::zero_server_port));
+        boost::asio::write(socket, boost::asio::buffer("Info benchmark " + type + "\n"));
+        boost::asio::streambuf read_buffer;
+        std::istream is(&read_buffer);
+        std::string command;
+        while (command.find(job_command) != 0) {
+            boost::asio::read_until(socket, read_buffer, '\n');
+            std::getline(is, command);
+        }
+        boost::this_thread::sleep(boost::posix_time::milliseconds(idle_milliseconds));
+        for (int i = 0; i < num_results; ++i) { boost::asio::write(socket, boost::asio::buffer(result)); }
+    };
+    boost::thread_group workers;
+    workers.create_thread(boost::bind<void>(fake_worker, "sp", "start", getSelfPlayMessage(false, "(;weight_iter_0)"), config::zero_num_games_per_iteration));
+    workers.create_thread(boost::bind<void>(fake_worker, "op", "train", "Optimization_Done 1\n", 1));
+
+    boost::posix_time::ptime start_ptime = TimeSystem::getLocalTime();
+    std::clock_t start_clock = std::clock();
+    server.runIterations(1);
+    double cpu_seconds = static_cast<double>(std::clock() - start_clock) / CLOCKS_PER_SEC;
+    double seconds = (TimeSystem::getLocalTime() - start_ptime).total_microseconds() / 1e6;
+    server.stop();
+    workers.join_all();
+
+    const double cpu_usage = cpu_seconds / seconds;
+    const bool is_idle = (cpu_usage <= kMaxIdleCPUUsage);
+    std::cout << "idle   wall time " << std::fixed << std::setprecision(2) << seconds << "s"
+              << " cpu time " << cpu_seconds << "s"
+              << " cpu usage " << std::setprecision(1) << cpu_usage * 100 << "%"
+              << (is_idle ? "" : " FAILED, exceeds " + std::to_string(static_cast<int>(kMaxIdleCPUUsage * 100)) + "%") << std::endl;
+    return is_idle;
+}
+
+void ZeroServerBenchmark::runTraining(bool async_training, int num_iterations, int train_milliseconds)
+{
+    const bool original_async_training = config::zero_server_async_training;
+    const int original_num_games_per_iteration = config::zero_num_games_per_iteration;
+    config::zero_server_async_training = async_training;
+    config::zero_num_games_per_iteration = 100;
+
+    std::unique_ptr<BenchmarkZeroServer> server = std::make_unique<BenchmarkZeroServer>();
+    server->startAccept();
+
+    // the fake self-play worker generates one game per 5 ms with the latest loaded model, tagged in the binary frame header
+    std::atomic<bool> is_done(false);
+    boost::thread_group workers;
+    workers.create_thread([this, &is_done]() {
+        boost::asio::io_service io_service;
+        boost::asio::ip::tcp::socket socket(io_service);
+        socket.connect(boost::asio::ip::tcp::endpoint(boost::asio::ip::address_v4::loopback(), config::zero_server_port));
+        boost::asio::write(socket, boost::asio::buffer(std::string("Info benchmark sp\n")));
+        boost::asio::streambuf read_buffer;
+        std::istream is(&read_buffer);
+        boost::system::error_code error;
+        bool running = false;
+        int model_iteration = 0;
+        while (!is_done && !error) {
+            while ((read_buffer.size() > 0 || socket.available(error) > 0) && boost::asio::read_until(socket, read_buffer, '\n', error) > 0) {
+                std::string command;
+                std::getline(is, command);
+                if (command.find("load_model") == 0) { model_iteration = std::atoi(command.c_str() + command.find("weight_iter_") + std::string("weight_iter_").size()); }
+                if (command == "start") { running = true; }
+                if (command == "stop") { running = false; }
+            }
+            if (running) {
+                BinaryFrameHeader header;
+                header.type_ = BinaryFrameHeader::Type::kSelfPlay;
+                header.flags_ = BinaryFrameHeader::kFlagTerminal;
+                header.game_length_ = header.data_length_ = 100;
+                header.model_iteration_ = model_iteration;
+                boost::asio::write(socket, boost::asio::buffer(header.toFrame("(;EV[weight_iter_" + std::to_string(model_iteration) + ".pt])")), error);
+            }
+            boost::this_thread::sleep(boost::posix_time::milliseconds(5));
+        }
+    });
+
+    // the fake trainer takes a fixed time for each optimization
+    workers.create_thread([train_milliseconds]() {
+        boost::asio::io_service io_service;
+        boost::asio::ip::tcp::socket socket(io_service);
+        socket.connect(boost::asio::ip::tcp::endpoint(boost::asio::ip::address_v4::loopback(), config::zero_server_port));
+        boost::asio::write(socket, boost::asio::buffer(std::string("Info benchmark op\n")));
+        boost::asio::streambuf read_buffer;
+        std::istream is(&read_buffer);
+        boost::system::error_code error;
+        for (int training_step = 0; boost::asio::read_until(socket, read_buffer, '\n', error) > 0 && !error;) {
+            std::string command;
+            std::getline(is, command);
+            if (command.find("train") != 0) { continue; }
+            boost::this_thread::sleep(boost::posix_time::milliseconds(train_milliseconds));
+            boost::asio::write(socket, boost::asio::buffer("Optimization_Done " + std::to_string(++training_step) + "\n"), error);
+        }
+    });
+
+    boost::posix_time::ptime start_ptime = TimeSystem::getLocalTime();
+    server->runIterations(num_iterations);
+    double seconds = (TimeSystem::getLocalTime() - start_ptime).total_microseconds() / 1e6;
+    is_done = true;
+    server->stop();
+    server.reset();
+    workers.join_all();
+    config::zero_server_async_training = original_async_training;
+    config::zero_num_games_per_iteration = original_num_games_per_iteration;
+
+    std::cout << (async_training ? "async " : "sync  ")
+              << " iterations " << num_iterations
+              << " training time " << train_milliseconds << "ms"
+              << " wall time " << std::fixed << std::setprecision(2) << seconds << "s" << std::endl;
+}
+
+std::string ZeroServerBenchmark::getSelfPlayMessage(bool use_binary_frame, const std::string& record) const
+{
+    if (use_binary_frame) {
+        BinaryFrameHeader header;
+        header.type_ = BinaryFrameHeader::Type::kSelfPlay;
+        header.flags_ = BinaryFrameHeader::kFlagTerminal;
+        header.data_length_ = 100;
+        header.game_length_ = 100;
+        header.return_ = 1.0f;
+        return header.toFrame(record);
+    }
+
+    std::ostringstream oss;
+    oss << "SelfPlay true 100 100 1 " << record << " #" << std::endl;
+    return oss.str();
+}
+
+} // namespace minizero::zero
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "base_server.h"
+#include "zero_server.h"
+#include <atomic>
+#include <memory>
+#include <string>
+
+namespace minizero::zero {
+
+class BenchmarkSharedData {
+public:
+    BenchmarkSharedData() : num_games_(0), num_bytes_(0) {}
+
+    std::atomic<int> num_games_;
+    std::atomic<long long> num_bytes_;
+};
+
+class BenchmarkWorkerHandler : public utils::ConnectionHandler {
+public:
+    BenchmarkWorkerHandler(boost::asio::io_service& io_service, BenchmarkSharedData& shared_data)
+        : ConnectionHandler(io_service),
+          shared_data_(shared_data)
+    {
+    }
+
+    void handleReceivedMessage(const std::string& message) override;
+    void handleReceivedFrame(const utils::BinaryFrameHeader& header, std::string& payload) override;
+
+private:
+    BenchmarkSharedData& shared_data_;
+};
+
+class BenchmarkServer : public utils::BaseServer<BenchmarkWorkerHandler> {
+public:
+    BenchmarkServer(int port, int num_threads) : BaseServer(port, num_threads) {}
+
+    boost::shared_ptr<BenchmarkWorkerHandler> handleAcceptNewConnection() override { return boost::make_shared<BenchmarkWorkerHandler>(io_service_, shared_data_); }
+    void sendInitialMessage(boost::shared_ptr<BenchmarkWorkerHandler> connection) override {}
+
+    BenchmarkSharedData shared_data_;
+};
+
+class BenchmarkZeroServer : public ZeroServer {
+public:
+    void runIterations(int num_iterations);
+};
+
+/**
+ * measure the throughput of the zero server receiving synthetic self-play games from workers over loopback sockets,
+ * the cpu usage of the zero server while waiting for slow workers, and the wall time of synchronous and asynchronous training with fake workers
+ * run() returns false if the idle cpu usage exceeds kMaxIdleCPUUsage, i.e., the server busy-waits for its workers
+ */
+class ZeroServerBenchmark {
+public:
+    static constexpr double kMaxIdleCPUUsage = 0.1;
+
+    bool run();
+
+private:
+    void runFraming(bool use_binary_frame, int num_io_threads, int num_workers, int num_games_per_worker, int record_size);
+    bool runIdle(int idle_milliseconds);
+    void runTraining(bool async_training, int num_iterations, int train_milliseconds);
+    std::string getSelfPlayMessage(bool use_binary_frame, const std::string& record) const;
+};
+
+} // namespace minizero::zero
@@ -0,0 +1,163 @@
+#!/usr/bin/env python
+
+import argparse
+import sys
+import time
+import torch
+import torch.nn as nn
+import numpy as np
+from torch.ao.quantization import get_default_qconfig_mapping, quantize_dynamic
+from torch.ao.quantization.quantize_fx import prepare_fx, convert_fx
+sys.path.append('.')
+from minizero.network.py.create_network import create_network
+from minizero.network.py.network_unit import ResidualBlock
+
+
+def eprint(*args, **kwargs):
+    print(*args, file=sys.stderr, **kwargs, flush=True)
+
+
+def load_network(model_file):
+    network = create_network(py.get_game_name(),
+                             py.get_nn_num_input_channels(),
+                             py.get_nn_input_channel_height(),
+                             py.get_nn_input_channel_width(),
+                             py.get_nn_num_hidden_channels(),
+                             py.get_nn_hidden_channel_height(),
+                             py.get_nn_hidden_channel_width(),
+                             py.get_nn_num_action_feature_channels(),
+                             py.get_nn_num_blocks(),
+                             py.get_nn_action_size(),
+                             py.get_nn_num_value_hidden_channels(),
+                             py.get_nn_discrete_value_size(),
+                             py.get_nn_type_name())
+    snapshot = torch.load(model_file, map_location=torch.device('cpu'))
+    network.load_state_dict(snapshot['network'])
+    network.eval()
+    return network
+
+
+def sample_features(data_loader, num_positions):
+    # sample positions from the loaded records, one batch of the training configuration at a time
+    batch_size = py.get_batch_size()
+    features = np.zeros(batch_size * py.get_nn_num_input_channels() * py.get_nn_input_channel_height() * py.get_nn_input_channel_width(), dtype=np.float32)
+    action_features = None
+    policy = np.zeros(batch_size * (py.get_muzero_unrolling_step() + 1) * py.get_nn_action_size(), dtype=np.float32)
+    value = np.zeros(batch_size * (py.get_muzero_unrolling_step() + 1) * py.get_nn_discrete_value_size(), dtype=np.float32)
+    reward = None
+    if py.get_nn_type_name() == "muzero":
+        action_features = np.zeros(batch_size * py.get_muzero_unrolling_step() * py.get_nn_num_action_feature_channels()
+                                   * py.get_nn_hidden_channel_height() * py.get_nn_hidden_channel_width(), dtype=np.float32)
+        reward = np.zeros(batch_size * py.get_muzero_unrolling_step() * py.get_nn_discrete_value_size(), dtype=np.float32)
+    loss_scale = np.zeros(batch_size, dtype=np.float32)
+    sampled_index = np.zeros(batch_size * 2, dtype=np.int32)
+
+    batches = []
+    for _ in range((num_positions + batch_size - 1) // batch_size):
+        data_loader.sample_data(features, action_features, policy, value, reward, loss_scale, sampled_index)
+        batch_features = torch.FloatTensor(features).view(batch_size, py.get_nn_num_input_channels(), py.get_nn_input_channel_height(), py.get_nn_input_channel_width())
+        batch_action_features = None if action_features is None else torch.FloatTensor(action_features).view(batch_size,
+                                                                                                              -1,
+                                                                                                              py.get_nn_num_action_feature_channels(),
+                                                                                                              py.get_nn_hidden_channel_height(),
+                                                                                                              py.get_nn_hidden_channel_width())[:, 0]
+        batches.append((batch_features, batch_action_features))
+    return batches
+
+
+def run_network(network, batch):
+    # run the initial inference, and one recurrent inference for muzero
+    features, action_features = batch
+    outputs = [network(features)]
+    if action_features is not None:
+        outputs.append(network(outputs[0]["hidden_state"], action_features))
+    return outputs
+
+
+def quantize_static(network, calibration_batches):
+    # quantize each residual block separately with its own observers, other layers stay in fp32
+    # blocks are traced by fx, which handles the residual addition and inserts the quantize/dequantize at their boundaries
+    qconfig_mapping = get_default_qconfig_mapping("fbgemm")
+    blocks = [(parent, name) for parent in network.modules() for name, child in parent.named_children() if isinstance(child, ResidualBlock)]
+    for parent, name in blocks:
+        block = getattr(parent, name)
+        example_input = torch.zeros(1, block.conv1.in_channels, py.get_nn_hidden_channel_height(), py.get_nn_hidden_channel_width())
+        setattr(parent, name, prepare_fx(block, qconfig_mapping, (example_input,)))
+
+    with torch.no_grad():
+        for batch in calibration_batches:
+            run_network(network, batch)
+
+    for parent, name in blocks:
+        setattr(parent, name, convert_fx(getattr(parent, name)))
+    return network
+
+
+def compare(fp32_network, int8_network, batches):
+    # policy kl divergence and value mean squared error of the quantized model against the fp32 model
+    value_accumulator = torch.ones(1) if py.get_nn_discrete_value_size() == 1 else torch.arange(-int(py.get_nn_discrete_value_size() / 2), int(py.get_nn_discrete_value_size() / 2) + 1).float()
+    policy_kl, value_mse, count = 0.0, 0.0, 0
+    with torch.no_grad():
+        for batch in batches:
+            for fp32_output, int8_output in zip(run_network(fp32_network, batch), run_network(int8_network, batch)):
+                fp32_policy = fp32_output["policy"].clamp_min(1e-12)
+                int8_policy = int8_output["policy"].clamp_min(1e-12)
+                policy_kl += (fp32_policy * (fp32_policy.log() - int8_policy.log())).sum(dim=1).sum().item()
+                fp32_value = (fp32_output["value"] * value_accumulator).sum(dim=1)
+                int8_value = (int8_output["value"] * value_accumulator).sum(dim=1)
+                value_mse += ((fp32_value - int8_value) ** 2).sum().item()
+                count += fp32_value.shape[0]
+    return policy_kl / count, value_mse / count
+
+
+def measure_throughput(network, batch, num_runs):
+    with torch.inference_mode():
+        run_network(network, batch)
+        start = time.time()
+        for _ in range(num_runs):
+            run_network(network, batch)
+        return num_runs * batch[0].shape[0] / (time.time() - start)
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser()
+    parser.add_argument('game_type', help='the game type of the pybind library, e.g., go')
+    parser.add_argument('conf_file', help='the configuration file')
+    parser.add_argument('model_file', help='the model snapshot, e.g., weight_iter_10000.pkl')
+    parser.add_argument('sgf_files', nargs='+', help='self-play records for calibration and evaluation')
+    parser.add_argument('-m', '--mode', choices=['dynamic', 'static'], default='dynamic',
+                        help='dynamic: int8 fully-connected layers; static: also int8 residual blocks calibrated by records (default: dynamic)')
+    parser.add_argument('-n', '--num_positions', type=int, default=1024, help='the number of positions for calibration and evaluation (default: 1024)')
+    parser.add_argument('-o', '--output', default='', help='the output torchscript file (default: model_file with _int8.pt)')
+    args = parser.parse_args()
+
+    # import pybind library
+    _temps = __import__(f'build.{args.game_type}', globals(), locals(), ['minizero_py'], 0)
+    py = _temps.minizero_py
+    py.load_config_file(args.conf_file)
+    torch.backends.quantized.engine = "fbgemm"
+
+    data_loader = py.DataLoader(args.conf_file)
+    data_loader.initialize()
+    for sgf_file in args.sgf_files:
+        data_loader.load_data_from_file(sgf_file)
+    calibration_batches = sample_features(data_loader, args.num_positions)
+    evaluation_batches = sample_features(data_loader, args.num_positions)
+
+    fp32_network = load_network(args.model_file)
+    int8_network = load_network(args.model_file)
+    if args.mode == 'static':
+        int8_network = quantize_static(int8_network, calibration_batches)
+    int8_network = quantize_dynamic(int8_network, {nn.Linear}, dtype=torch.qint8)
+    int8_network = torch.jit.script(int8_network)
+
+    policy_kl, value_mse = compare(fp32_network, int8_network, evaluation_batches)
+    fp32_throughput = measure_throughput(torch.jit.script(fp32_network), evaluation_batches[0], 20)
+    int8_throughput = measure_throughput(int8_network, evaluation_batches[0], 20)
+    eprint(f"mode: {args.mode}, positions: {len(evaluation_batches) * py.get_batch_size()}")
+    eprint(f"policy kl: {policy_kl:.6f}, value mse: {value_mse:.6f}")
+    eprint(f"throughput (positions/s): fp32 {fp32_throughput:.1f}, int8 {int8_throughput:.1f}, speedup {int8_throughput / fp32_throughput:.2f}x")
+
+    output = args.output if args.output else args.model_file.replace('.pkl', '_int8.pt')
+    int8_network.save(output, _extra_files={"network_type_name": int8_network.get_type_name()})
+    eprint(f"save quantized model to {output}")